@@ -23,6 +23,27 @@ cd build
 echo "Building ring"
 ./build-index ../$1/wikidata-wcg-filtered-num.nt ring > ../$2/buildOutput/ring
 echo "[Done]"
+echo "Building ring-simd"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-simd > ../$2/buildOutput/ring-simd
+echo "[Done]"
+echo "Building ring-cl"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-cl > ../$2/buildOutput/ring-cl
+echo "[Done]"
+echo "Building ring-alpha"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-alpha > ../$2/buildOutput/ring-alpha
+echo "[Done]"
+echo "Building ring-ap"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-ap > ../$2/buildOutput/ring-ap
+echo "[Done]"
+echo "Building ring-delta"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-delta > ../$2/buildOutput/ring-delta
+echo "[Done]"
+echo "Building ring-dyn-read"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-dyn-read > ../$2/buildOutput/ring-dyn-read
+echo "[Done]"
+echo "Building ring-dyn-update"
+./build-index ../$1/wikidata-wcg-filtered-num.nt ring-dyn-update > ../$2/buildOutput/ring-dyn-update
+echo "[Done]"
 echo "Building ring-c"
 ./build-index ../$1/wikidata-wcg-filtered-num.nt c-ring > ../$2/buildOutput/ring-c
 echo "[Done]"
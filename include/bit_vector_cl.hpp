@@ -0,0 +1,376 @@
+/*
+ * bit_vector_cl.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_BIT_VECTOR_CL_HPP
+#define RING_BIT_VECTOR_CL_HPP
+
+#include <cstring>
+#include "configuration.hpp"
+#include "rank_select_simd.hpp"
+
+namespace ring {
+
+    template<uint8_t t_b>
+    class rank_support_cl;
+
+    template<uint8_t t_b>
+    class select_support_cl;
+
+    /**
+     * @brief Bitvector whose bits are interleaved with their rank counters.
+     * Every 64-byte block (one cache line) stores the number of ones before it
+     * in its first word followed by 448 bits of payload, so a rank touches a
+     * single cache line.
+     */
+    class bit_vector_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef rank_support_cl<1> rank_1_type;
+        typedef rank_support_cl<0> rank_0_type;
+        typedef select_support_cl<1> select_1_type;
+        typedef select_support_cl<0> select_0_type;
+
+        static const uint64_t block_words = 8;
+        static const uint64_t block_bits = 448; // payload bits in a block
+
+    private:
+        size_type m_size = 0;
+        size_type m_blocks = 0;
+        std::vector<uint64_t> m_data; // allocated with room to align the blocks to 64 bytes
+        size_type m_offset = 0;       // first word of the first block within m_data
+
+        template<uint8_t>
+        friend class rank_support_cl;
+
+        template<uint8_t>
+        friend class select_support_cl;
+
+        void allocate(size_type n_blocks) {
+            m_blocks = n_blocks;
+            m_data.assign(m_blocks * block_words + block_words - 1, 0);
+            m_offset = aligned_offset();
+        }
+
+        size_type aligned_offset() const {
+            uintptr_t addr = (uintptr_t) m_data.data();
+            return ((64 - (addr & 63)) & 63) >> 3;
+        }
+
+        //! Moves the blocks to the 64-byte boundary of the current buffer
+        void realign(size_type old_offset) {
+            m_offset = aligned_offset();
+            if (m_offset != old_offset && m_blocks > 0) {
+                std::memmove(m_data.data() + m_offset, m_data.data() + old_offset,
+                             m_blocks * block_words * sizeof(uint64_t));
+            }
+        }
+
+        inline const uint64_t *block(size_type b) const {
+            return m_data.data() + m_offset + b * block_words;
+        }
+
+        inline uint64_t *block(size_type b) {
+            return m_data.data() + m_offset + b * block_words;
+        }
+
+        void copy(const bit_vector_cl &o) {
+            m_size = o.m_size;
+            m_blocks = o.m_blocks;
+            m_data = o.m_data;
+            realign(o.m_offset);
+        }
+
+    public:
+        bit_vector_cl() = default;
+
+        bit_vector_cl(const bit_vector &bv) {
+            m_size = bv.size();
+            allocate(m_size / block_bits + 1);
+            uint64_t ones = 0;
+            for (size_type b = 0; b < m_blocks; ++b) {
+                uint64_t *blk = block(b);
+                blk[0] = ones;
+                size_type start = b * block_bits;
+                for (size_type w = 0; w < block_words - 1 && start + w * 64 < m_size; ++w) {
+                    size_type len = std::min<size_type>(64, m_size - start - w * 64);
+                    blk[w + 1] = bv.get_int(start + w * 64, (uint8_t) len);
+                    ones += sdsl::bits::cnt(blk[w + 1]);
+                }
+            }
+        }
+
+        //! Copy constructor
+        bit_vector_cl(const bit_vector_cl &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        bit_vector_cl(bit_vector_cl &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        bit_vector_cl &operator=(const bit_vector_cl &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        bit_vector_cl &operator=(bit_vector_cl &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_blocks = o.m_blocks;
+                m_data = std::move(o.m_data);
+                m_offset = o.m_offset;
+            }
+            return *this;
+        }
+
+        void swap(bit_vector_cl &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_blocks, o.m_blocks);
+            m_data.swap(o.m_data);
+            std::swap(m_offset, o.m_offset);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline value_type operator[](size_type i) const {
+            return (block(i / block_bits)[1 + (i % block_bits) / 64] >> (i % 64)) & 1ULL;
+        }
+
+        //! Integer of len bits (len <= 64) starting at position idx
+        uint64_t get_int(size_type idx, uint8_t len = 64) const {
+            uint64_t res = 0;
+            uint8_t done = 0;
+            while (done < len) {
+                size_type i = idx + done;
+                size_type in_word = i % 64;
+                uint8_t take = (uint8_t) std::min<size_type>(64 - in_word, len - done);
+                uint64_t word = block(i / block_bits)[1 + (i % block_bits) / 64] >> in_word;
+                if (take < 64) word &= (1ULL << take) - 1;
+                res |= word << done;
+                done += take;
+            }
+            return res;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "bit_vector_cl");
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_blocks, out, child, "blocks");
+            if (m_blocks > 0) {
+                out.write((const char *) block(0), m_blocks * block_words * sizeof(uint64_t));
+                written_bytes += m_blocks * block_words * sizeof(uint64_t);
+            }
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            size_type n_blocks;
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(n_blocks, in);
+            allocate(n_blocks);
+            if (m_blocks > 0) {
+                in.read((char *) block(0), m_blocks * block_words * sizeof(uint64_t));
+            }
+        }
+    };
+
+    /**
+     * @brief Rank support of bit_vector_cl. The counters live inside the
+     * bitvector, so this class only keeps a pointer to it.
+     *
+     * @tparam t_b The bit pattern being ranked (0 or 1)
+     */
+    template<uint8_t t_b = 1>
+    class rank_support_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_cl bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t) 1 };
+
+    private:
+        const bit_vector_type *m_v = nullptr;
+
+    public:
+        explicit rank_support_cl(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        //! Number of t_b bits in [0, i)
+        inline size_type rank(size_type i) const {
+            const uint64_t *blk = m_v->block(i / bit_vector_type::block_bits);
+            size_type off = i % bit_vector_type::block_bits;
+            uint64_t res = blk[0];
+            //At most 6 words: popcnt of each word is cheaper than a call to the SIMD kernel
+            for (size_type w = 0; w < (off >> 6); ++w) {
+                res += sdsl::bits::cnt(blk[1 + w]);
+            }
+            if (off & 63) {
+                res += sdsl::bits::cnt(blk[1 + (off >> 6)] & ((1ULL << (off & 63)) - 1));
+            }
+            return t_b ? res : i - res;
+        }
+
+        inline size_type operator()(size_type i) const {
+            return rank(i);
+        }
+
+        size_type size() const {
+            return m_v == nullptr ? 0 : m_v->size();
+        }
+
+        void set_vector(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(rank_support_cl &) {}
+
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "rank_support_cl");
+            sdsl::structure_tree::add_size(child, 0);
+            return 0;
+        }
+
+        void load(std::istream &, const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+    };
+
+    /**
+     * @brief Select support of bit_vector_cl. Samples the block of every
+     * 4096-th t_b bit and binary searches the in-line counters between samples.
+     *
+     * @tparam t_b The bit pattern being selected (0 or 1)
+     */
+    template<uint8_t t_b = 1>
+    class select_support_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_cl bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t) 1 };
+
+    private:
+        static const uint64_t sample_rate = 4096;
+
+        const bit_vector_type *m_v = nullptr;
+        int_vector<64> m_samples;
+        simd::select_word_type m_select_word = simd::kernels().select_word; //Resolved once per structure
+
+        inline uint64_t count_before_block(uint64_t b) const {
+            uint64_t ones = m_v->block(b)[0];
+            return t_b ? ones : b * bit_vector_type::block_bits - ones;
+        }
+
+        inline uint64_t pattern_word(uint64_t word) const {
+            return t_b ? word : ~word;
+        }
+
+        void build() {
+            uint64_t n_blocks = m_v->m_blocks;
+            uint64_t n = m_v->size();
+            uint64_t ones = n_blocks == 0 ? 0 : rank_support_cl<1>(m_v).rank(n);
+            uint64_t total = t_b ? ones : n - ones;
+            m_samples = int_vector<64>(total / sample_rate + 1, 0);
+            uint64_t b = 0;
+            for (uint64_t k = 0; k < m_samples.size(); ++k) {
+                while (b + 1 < n_blocks && count_before_block(b + 1) <= k * sample_rate) {
+                    ++b;
+                }
+                m_samples[k] = b;
+            }
+        }
+
+    public:
+        explicit select_support_cl(const bit_vector_type *v = nullptr) {
+            m_v = v;
+            if (m_v != nullptr) {
+                build();
+            }
+        }
+
+        //! Position of the i-th (i >= 1) t_b bit
+        inline size_type select(size_type i) const {
+            uint64_t k = (i - 1) / sample_rate;
+            uint64_t lo = m_samples[k];
+            uint64_t hi = (k + 1 < m_samples.size()) ? m_samples[k + 1] : m_v->m_blocks - 1;
+            while (lo < hi) {
+                uint64_t mid = (lo + hi + 1) >> 1;
+                if (count_before_block(mid) < i) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            uint64_t rem = i - count_before_block(lo);
+            const uint64_t *blk = m_v->block(lo);
+            uint64_t w = 0;
+            for (;; ++w) {
+                uint64_t c = sdsl::bits::cnt(pattern_word(blk[1 + w]));
+                if (rem <= c) break;
+                rem -= c;
+            }
+            return lo * bit_vector_type::block_bits + (w << 6)
+                   + m_select_word(pattern_word(blk[1 + w]), rem);
+        }
+
+        inline size_type operator()(size_type i) const {
+            return select(i);
+        }
+
+        void set_vector(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(select_support_cl &o) {
+            m_samples.swap(o.m_samples);
+            std::swap(m_select_word, o.m_select_word);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "select_support_cl");
+            size_type written_bytes = m_samples.serialize(out, child, "samples");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in, const bit_vector_type *v = nullptr) {
+            m_v = v;
+            m_select_word = simd::kernels().select_word;
+            m_samples.load(in);
+        }
+    };
+}
+
+#endif
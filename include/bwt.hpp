@@ -22,6 +22,10 @@
 #define BWT_T
 
 #include "configuration.hpp"
+#include "rank_select_simd.hpp"
+#include "bit_vector_cl.hpp"
+#include "wt_alpha.hpp"
+#include "wt_ap.hpp"
 
 using namespace std;
 
@@ -31,7 +35,8 @@ namespace ring {
     template <class bwt_bit_vector_t = bit_vector,
             class bwt_rank_1_t = typename bit_vector::rank_1_type,
             class bwt_select_1_t = select_support_scan<1>,
-            class bwt_select_0_t = select_support_scan<0>>
+            class bwt_select_0_t = select_support_scan<0>,
+            class bwt_wm_t = sdsl::wm_int<bwt_bit_vector_t, bwt_rank_1_t, bwt_select_1_t, bwt_select_0_t>>
     class bwt {
 
     public:
@@ -41,7 +46,10 @@ namespace ring {
         typedef sdsl::rank_support_v<> c_rank_type;
         typedef sdsl::select_support_mcl<1> c_select_1_type;
         typedef sdsl::select_support_mcl<0> c_select_0_type;
-        typedef sdsl::wm_int<bwt_bit_vector_t, bwt_rank_1_t, bwt_select_1_t, bwt_select_0_t> bwt_type;
+        typedef bwt_wm_t bwt_type;
+
+        //! C is also kept as a plain array when it has at most this many entries
+        static const uint64_t c_cache_max_sigma = 1ULL << 16;
 
     private:
         bwt_type m_L;
@@ -49,10 +57,23 @@ namespace ring {
         c_rank_type m_C_rank;
         c_select_1_type m_C_select1;
         c_select_0_type m_C_select0;
+        int_vector<> m_C_cache; // get_C(v) for every v, empty if the alphabet is large
+
+        void build_C_cache() {
+            uint64_t n_values = m_C_rank(m_C.size());
+            m_C_cache = int_vector<>();
+            if (n_values > c_cache_max_sigma) return;
+            m_C_cache = int_vector<>(n_values, 0);
+            for (uint64_t v = 0; v < n_values; ++v) {
+                m_C_cache[v] = m_C_select1(v + 1) - v;
+            }
+            util::bit_compress(m_C_cache);
+        }
 
         void copy(const bwt &o) {
             m_L = o.m_L;
             m_C = o.m_C;
+            m_C_cache = o.m_C_cache;
             m_C_rank = o.m_C_rank;
             m_C_rank.set_vector(&m_C);
             m_C_select1 = o.m_C_select1;
@@ -77,6 +98,7 @@ namespace ring {
             util::init_support(m_C_rank, &m_C);
             util::init_support(m_C_select1, &m_C);
             util::init_support(m_C_select0, &m_C);
+            build_C_cache();
         }
 
 
@@ -109,6 +131,7 @@ namespace ring {
                 m_C_select1.set_vector(&m_C);
                 m_C_select0 = std::move(o.m_C_select0);
                 m_C_select0.set_vector(&m_C);
+                m_C_cache = std::move(o.m_C_cache);
             }
             return *this;
         }
@@ -148,6 +171,7 @@ namespace ring {
             sdsl::util::swap_support(m_C_rank, o.m_C_rank, &m_C, &o.m_C);
             sdsl::util::swap_support(m_C_select1, o.m_C_select1, &m_C, &o.m_C);
             sdsl::util::swap_support(m_C_select0, o.m_C_select0, &m_C, &o.m_C);
+            m_C_cache.swap(o.m_C_cache);
         }
 
 
@@ -170,10 +194,12 @@ namespace ring {
             m_C_rank.load(in, &m_C);
             m_C_select1.load(in, &m_C);
             m_C_select0.load(in, &m_C);
+            build_C_cache();
         }
 
         //Operations
         inline size_type get_C(const uint64_t v) const {
+            if (v < m_C_cache.size()) return m_C_cache[v];
             return m_C_select1(v + 1) - v;
         }
 
@@ -260,6 +286,18 @@ namespace ring {
             return m_L[i];
         }
 
+        //! Extracts L and the C array, as given to the constructor
+        void decode(vector<uint64_t> &L, vector<uint64_t> &C) const {
+            L.resize(m_L.size());
+            for (uint64_t i = 0; i < m_L.size(); i++) {
+                L[i] = m_L[i];
+            }
+            C.resize(m_C_rank(m_C.size()));
+            for (uint64_t v = 0; v < C.size(); v++) {
+                C[v] = get_C(v);
+            }
+        }
+
     };
 
     typedef bwt<> bwt_no_select;
@@ -272,6 +310,29 @@ namespace ring {
             typename rrr_vector<15>::rank_1_type,
             typename rrr_vector<15>::select_1_type,
             typename rrr_vector<15>::select_0_type> bwt_rrr;
+
+    typedef bwt<bit_vector_simd,
+                rank_support_simd<1>,
+                select_support_simd<1>,
+                select_support_simd<0>> bwt_simd;
+    typedef bwt<bit_vector_cl,
+                rank_support_cl<1>,
+                select_support_cl<1>,
+                select_support_cl<0>> bwt_cl;
+
+    // Entropy-shaped, order-preserving wavelet tree; meant for the skewed predicate alphabet
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                typename bit_vector::select_1_type,
+                typename bit_vector::select_0_type,
+                wt_alpha<>> bwt_alpha;
+
+    // Alphabet-partitioned sequence; meant for the large SO alphabet
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                typename bit_vector::select_1_type,
+                typename bit_vector::select_0_type,
+                wt_ap<>> bwt_ap;
 }
 
 #endif
@@ -0,0 +1,92 @@
+/*
+ * cancel_token.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_CANCEL_TOKEN_HPP
+#define RING_CANCEL_TOKEN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ring {
+
+    /**
+     * @brief Stops a join, either at a deadline or when another thread calls
+     * cancel(). The join polls stop() at every step: it reads an atomic flag,
+     * and only reads the clock once every check_every steps.
+     */
+    class cancel_token {
+
+    public:
+        typedef uint64_t size_type;
+        typedef std::chrono::steady_clock clock_type;
+
+    private:
+        std::atomic<bool> m_cancelled{false};
+        bool m_has_deadline = false;
+        clock_type::time_point m_deadline;
+        size_type m_mask;
+        size_type m_steps = 0;
+
+    public:
+
+        /**
+         * @param timeout_ms    Milliseconds from now until the deadline, 0 for none
+         * @param check_every   Steps between two reads of the clock (rounded up to a power of two)
+         */
+        cancel_token(const size_type timeout_ms = 0, const size_type check_every = 1024) {
+            size_type n = 1;
+            while (n < check_every) n <<= 1;
+            m_mask = n - 1;
+            if (timeout_ms > 0) set_timeout(timeout_ms);
+        }
+
+        cancel_token(const cancel_token &) = delete;
+
+        cancel_token &operator=(const cancel_token &) = delete;
+
+        //! Sets the deadline timeout_ms milliseconds from now
+        void set_timeout(const size_type timeout_ms) {
+            m_has_deadline = true;
+            m_deadline = clock_type::now() + std::chrono::milliseconds(timeout_ms);
+        }
+
+        //! Stops the joins using the token; can be called from any thread
+        void cancel() {
+            m_cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        //! True once the token was cancelled or its deadline passed
+        bool cancelled() const {
+            return m_cancelled.load(std::memory_order_relaxed);
+        }
+
+        //! Called by the join at every step; only the thread of the join may call it
+        inline bool stop() {
+            if (m_cancelled.load(std::memory_order_relaxed)) return true;
+            if (m_has_deadline && (++m_steps & m_mask) == 0 && clock_type::now() >= m_deadline) {
+                cancel();
+                return true;
+            }
+            return false;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ * chunk_store.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_CHUNK_STORE_HPP
+#define RING_CHUNK_STORE_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <set>
+#include <streambuf>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "configuration.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Paged on-disk format for structures that are serialized as a whole,
+     * such as the dynamic rings. The serialization is cut into chunks at
+     * content-defined boundaries (gear rolling hash), and every chunk is stored
+     * once in <manifest>.chunks/, named after its content. The manifest lists
+     * the chunks of the current version.
+     *
+     * An update only changes the bytes of the tree nodes it touches, and the
+     * boundaries resynchronize right after them, so storing a new version only
+     * writes the chunks around the modified nodes: the cost on disk scales with
+     * the number of updates instead of the size of the index. The CPU cost does
+     * not: the whole structure is still serialized, cut and hashed on every
+     * store, which is O(size of the index). Skipping the unchanged parts would
+     * need the structures to track their dirty nodes.
+     *
+     * The serialization is cut and hashed while it is written (chunk_writer),
+     * and read back one chunk at a time (chunk_reader), so storing or loading
+     * never holds more than a chunk of it in memory besides the manifest.
+     */
+    class chunk_store {
+
+    public:
+        typedef uint64_t size_type;
+
+        static const size_type min_chunk = 1024;
+        static const size_type max_chunk = 16384;
+        static const uint64_t boundary_mask = (1ULL << 12) - 1; // 4 KiB on average
+
+    private:
+        struct chunk_id {
+            uint64_t h1;
+            uint64_t h2;
+            uint32_t length;
+        };
+
+        std::string m_manifest;
+        std::string m_dir;
+        size_type m_written_chunks = 0;
+        size_type m_written_bytes = 0;
+
+        static const char *magic() {
+            return "RINGPAGE";
+        }
+
+        struct gear_table {
+            uint64_t values[256];
+
+            gear_table() {
+                uint64_t x = 0x9E3779B97F4A7C15ULL;
+                for (auto &t : values) { // splitmix64
+                    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                    t = z ^ (z >> 31);
+                }
+            }
+        };
+
+        //! The table is built once, on the first call from any thread
+        static const uint64_t *gear() {
+            static const gear_table table;
+            return table.values;
+        }
+
+        static chunk_id hash(const char *data, size_type n) {
+            uint64_t h1 = 14695981039346656037ULL, h2 = 0x84222325CBF29CE4ULL;
+            for (size_type i = 0; i < n; ++i) {
+                h1 = (h1 ^ (uint8_t) data[i]) * 1099511628211ULL;
+                h2 = (h2 + (uint8_t) data[i] + 1) * 0xFF51AFD7ED558CCDULL;
+                h2 ^= h2 >> 29;
+            }
+            return {h1, h2, (uint32_t) n};
+        }
+
+        std::string chunk_file(const chunk_id &c) const {
+            char name[48];
+            snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long) c.h1, (unsigned long long) c.h2);
+            return m_dir + "/" + name;
+        }
+
+        static bool exists(const std::string &file) {
+            return access(file.c_str(), F_OK) == 0;
+        }
+
+        static void write_file(const std::string &file, const char *data, size_type n) {
+            FILE *f = fopen(file.c_str(), "wb");
+            if (!f) throw std::runtime_error("Cannot write " + file);
+            fwrite(data, 1, n, f);
+            fflush(f);
+            fsync(fileno(f));
+            fclose(f);
+        }
+
+        static void sync_dir(const std::string &dir) {
+            int fd = open(dir.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            fsync(fd);
+            close(fd);
+        }
+
+        //! Stores a chunk unless it is already stored
+        chunk_id put_chunk(const char *data, size_type n) {
+            chunk_id c = hash(data, n);
+            std::string name = chunk_file(c);
+            if (!exists(name)) {
+                write_file(name + ".tmp", data, n);
+                std::rename((name + ".tmp").c_str(), name.c_str());
+                ++m_written_chunks;
+                m_written_bytes += c.length;
+            }
+            return c;
+        }
+
+        //! Output buffer that cuts the bytes written into chunks as they arrive
+        class chunk_writer : public std::streambuf {
+            chunk_store &m_store;
+            std::vector<chunk_id> m_chunks;
+            std::string m_chunk;
+            uint64_t m_h = 0;
+            char m_buffer[4096];
+
+            void emit() {
+                if (m_chunk.empty()) return;
+                m_chunks.push_back(m_store.put_chunk(m_chunk.data(), m_chunk.size()));
+                m_chunk.clear();
+                m_h = 0;
+            }
+
+            //! Gear rolling hash over the bytes of the current chunk
+            void consume(const char *data, size_type n) {
+                const uint64_t *g = gear();
+                for (size_type i = 0; i < n; ++i) {
+                    m_chunk.push_back(data[i]);
+                    m_h = (m_h << 1) + g[(uint8_t) data[i]];
+                    size_type len = m_chunk.size();
+                    if ((len >= min_chunk && (m_h & boundary_mask) == 0) || len >= max_chunk) emit();
+                }
+            }
+
+            void drain() {
+                consume(pbase(), pptr() - pbase());
+                setp(m_buffer, m_buffer + sizeof(m_buffer));
+            }
+
+        protected:
+            int_type overflow(int_type c) override {
+                drain();
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            int sync() override {
+                drain();
+                return 0;
+            }
+
+        public:
+            chunk_writer(chunk_store &store) : m_store(store) {
+                m_chunk.reserve(max_chunk);
+                setp(m_buffer, m_buffer + sizeof(m_buffer));
+            }
+
+            //! Chunks of everything written, the last one included
+            const std::vector<chunk_id> &finish() {
+                drain();
+                emit();
+                return m_chunks;
+            }
+        };
+
+        //! Input buffer that reads the chunks of a manifest on demand
+        class chunk_reader : public std::streambuf {
+            const chunk_store &m_store;
+            std::vector<chunk_id> m_chunks;
+            size_type m_next = 0;
+            std::vector<char> m_chunk;
+
+        protected:
+            int_type underflow() override {
+                if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+                if (m_next == m_chunks.size()) return traits_type::eof();
+                const chunk_id &c = m_chunks[m_next++];
+                std::ifstream in(m_store.chunk_file(c), std::ios::binary);
+                m_chunk.resize(c.length);
+                if (!in.read(m_chunk.data(), c.length) || in.peek() != std::ifstream::traits_type::eof()) {
+                    throw std::runtime_error("Missing chunk " + m_store.chunk_file(c));
+                }
+                setg(m_chunk.data(), m_chunk.data(), m_chunk.data() + c.length);
+                return traits_type::to_int_type(*gptr());
+            }
+
+        public:
+            chunk_reader(const chunk_store &store) : m_store(store), m_chunks(read_manifest(store.m_manifest)) {}
+        };
+
+        //! Chunks listed by a manifest; empty if it does not exist
+        static std::vector<chunk_id> read_manifest(const std::string &manifest) {
+            std::vector<chunk_id> chunks;
+            std::ifstream in(manifest, std::ios::binary);
+            char m[8];
+            if (!in.read(m, 8) || std::memcmp(m, magic(), 8) != 0) return chunks;
+            uint64_t n;
+            in.read((char *) &n, sizeof(n));
+            chunks.resize(n);
+            for (auto &c : chunks) {
+                in.read((char *) &c.h1, sizeof(c.h1));
+                in.read((char *) &c.h2, sizeof(c.h2));
+                in.read((char *) &c.length, sizeof(c.length));
+            }
+            if (!in) throw std::runtime_error("Truncated manifest " + manifest);
+            return chunks;
+        }
+
+        //! Removes the chunks not used by the current version
+        void collect() {
+            std::set<std::string> used;
+            for (const auto &c : read_manifest(m_manifest)) {
+                used.insert(chunk_file(c));
+            }
+            DIR *d = opendir(m_dir.c_str());
+            if (!d) return;
+            while (struct dirent *e = readdir(d)) {
+                std::string file = m_dir + "/" + e->d_name;
+                if (e->d_name[0] != '.' && !used.count(file)) {
+                    std::remove(file.c_str());
+                }
+            }
+            closedir(d);
+        }
+
+    public:
+        //! The chunks of manifest are stored in manifest.chunks/
+        chunk_store(const std::string &manifest) : m_manifest(manifest), m_dir(manifest + ".chunks") {}
+
+        //! True if file is a manifest of a paged structure
+        static bool is_paged(const std::string &file) {
+            std::ifstream in(file, std::ios::binary);
+            char m[8];
+            return in.read(m, 8) && std::memcmp(m, magic(), 8) == 0;
+        }
+
+        /**
+         * @brief Writes the chunks of obj that are not stored yet and its manifest
+         * into file, which is renamed to the manifest by the caller to commit the
+         * new version. Chunks only used by older versions are removed first.
+         *
+         * @return Bytes written
+         */
+        template <class T>
+        size_type write_to(const T &obj, const std::string &file) {
+            mkdir(m_dir.c_str(), 0755);
+            collect();
+            m_written_chunks = m_written_bytes = 0;
+            chunk_writer buffer(*this);
+            std::ostream out(&buffer);
+            obj.serialize(out);
+            out.flush();
+            const std::vector<chunk_id> &chunks = buffer.finish();
+
+            std::string manifest(magic(), 8);
+            uint64_t n = chunks.size();
+            manifest.append((const char *) &n, sizeof(n));
+            for (const auto &c : chunks) {
+                manifest.append((const char *) &c.h1, sizeof(c.h1));
+                manifest.append((const char *) &c.h2, sizeof(c.h2));
+                manifest.append((const char *) &c.length, sizeof(c.length));
+            }
+            sync_dir(m_dir);
+            write_file(file, manifest.data(), manifest.size());
+            m_written_bytes += manifest.size();
+            return m_written_bytes;
+        }
+
+        //! Stores a new version of obj atomically
+        template <class T>
+        size_type store(const T &obj) {
+            size_type bytes = write_to(obj, m_manifest + ".tmp");
+            std::rename((m_manifest + ".tmp").c_str(), m_manifest.c_str());
+            auto p = m_manifest.find_last_of('/');
+            sync_dir(p == std::string::npos ? "." : m_manifest.substr(0, p + 1));
+            return bytes;
+        }
+
+        template <class T>
+        void load(T &obj) const {
+            chunk_reader buffer(*this);
+            std::istream in(&buffer);
+            in.exceptions(std::ios::badbit); //A missing chunk is reported, not turned into a short read
+            obj.load(in);
+        }
+
+        //! Chunks written by the last store
+        size_type written_chunks() const {
+            return m_written_chunks;
+        }
+
+        //! Bytes written by the last store, manifest included
+        size_type written_bytes() const {
+            return m_written_bytes;
+        }
+    };
+
+    //! Loads an index stored either as a single file or paged
+    template <class T>
+    void load_index(T &obj, const std::string &file) {
+        if (chunk_store::is_paged(file)) {
+            chunk_store(file).load(obj);
+        } else {
+            sdsl::load_from_file(obj, file);
+        }
+    }
+}
+
+#endif
@@ -20,6 +20,8 @@
 #ifndef DICT_MAP_HPP
 #define DICT_MAP_HPP
 
+#include <map>
+#include <algorithm>
 #include "pfc.hpp"
 
 namespace ring
@@ -161,7 +163,9 @@ namespace ring
       if (free_ids_size == 0)
       {
         id = id_map.size() + 1;
-        id_map.push_back({ .pfc = root->insert(val, id, id_map)});
+        // The slot must exist before inserting, a split updates it
+        id_map.push_back({ .pfc = nullptr });
+        id_map[id - 1].pfc = root->insert(val, id, id_map);
       }
       else
       {
@@ -194,11 +198,16 @@ namespace ring
       if (free_ids_size == 0)
       {
         id = id_map.size() + 1;
+        id_map.push_back({ .pfc = nullptr });
         res = root->get_or_insert(val, id, id_map);
         found_id = std::get<0>(res);
         if (found_id == id)
         {
-          id_map.push_back({ .pfc = std::get<1>(res) });
+          id_map[id - 1].pfc = std::get<1>(res);
+        }
+        else
+        {
+          id_map.pop_back();
         }
       }
       else
@@ -287,6 +296,80 @@ namespace ring
       return root->search(val);
     }
 
+    /**
+     * @brief Searches many values at once. The values are sorted and resolved
+     * in one in-order traversal of the tree, scanning every PFC leaf once
+     *
+     * @param vals values being searched
+     * @return std::vector<uint64_t> the ID of each value (0 if it is not in the mapping)
+     */
+    std::vector<uint64_t> locate_batch(const std::vector<std::string> &vals)
+    {
+      std::vector<std::string> sorted(vals);
+      std::sort(sorted.begin(), sorted.end());
+      sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+      std::vector<uint64_t> sorted_ids(sorted.size());
+      if (!sorted.empty())
+        root->locate_batch(sorted, 0, sorted.size(), sorted_ids);
+
+      std::vector<uint64_t> ids(vals.size());
+      for (uint64_t i = 0; i < vals.size(); i++)
+      {
+        ids[i] = sorted_ids[std::lower_bound(sorted.begin(), sorted.end(), vals[i]) - sorted.begin()];
+      }
+      return ids;
+    }
+
+    /**
+     * @brief Gets the IDs of the neighbours of a value that is not in the mapping
+     *
+     * @param val value not in the mapping
+     * @return std::pair<uint64_t, uint64_t> IDs of the largest value smaller
+     * than val and of the smallest value greater than val, 0 if there is none
+     */
+    std::pair<uint64_t, uint64_t> locate_neighbours(const std::string &val)
+    {
+      uint64_t prev = 0, next = 0;
+      root->neighbours(val, prev, next);
+      return std::make_pair(prev, next);
+    }
+
+    /**
+     * @brief Deletes many values from the mapping by ID. The IDs are grouped by
+     * PFC leaf, so each leaf is rewritten once
+     *
+     * @param ids IDs of the values being eliminated
+     */
+    void eliminate_batch(const std::vector<uint64_t> &ids)
+    {
+      std::map<PFC *, std::vector<uint64_t>> by_leaf;
+      for (uint64_t id : ids)
+      {
+        by_leaf[id_map[id - 1].pfc].push_back(id);
+      }
+      for (auto &leaf : by_leaf)
+      {
+        std::sort(leaf.second.begin(), leaf.second.end());
+        leaf.second.erase(std::unique(leaf.second.begin(), leaf.second.end()), leaf.second.end());
+        leaf.first->elim_batch(leaf.second);
+        for (uint64_t id : leaf.second)
+        {
+          id_map[id - 1].pfc = nullptr;
+          // First in "Symbolic queue"
+          if (free_ids_size == 0)
+          {
+            first_empty = id;
+          }
+          else
+          {
+            id_map[last_empty - 1].next_empty = id;
+          }
+          last_empty = id;
+          free_ids_size++;
+        }
+      }
+    }
+
     /**
      * @brief Search for an ID in the structure and get its corresponding value
      *
@@ -310,6 +393,39 @@ namespace ring
       return 8 * sizeof(root) + id_size + root->bit_size();
     }
 
+    /**
+     * @brief Renames the IDs: every ID becomes map[ID]. Values whose new ID is 0
+     * are deleted, and the queue of free IDs is emptied, so the new IDs
+     * should be dense (1..max).
+     *
+     * @param map New ID of every old ID (0 if the value is not used anymore)
+     */
+    void remap(const std::vector<uint64_t> &map)
+    {
+      std::vector<bool> is_free(id_map.size() + 1, false);
+      for (uint64_t i = 0, id = first_empty; i < free_ids_size; i++)
+      {
+        is_free[id] = true;
+        id = id_map[id - 1].next_empty;
+      }
+      uint64_t new_size = 0;
+      for (uint64_t id = 1; id <= id_map.size(); id++)
+      {
+        if (is_free[id])
+          continue;
+        if (id >= map.size() || map[id] == 0)
+          id_map[id - 1].pfc->elim(id);
+        else
+          new_size = std::max(new_size, map[id]);
+      }
+
+      std::vector<uint64_t> full_map(map);
+      full_map.resize(id_map.size() + 1, 0);
+      id_map = std::vector<EmptyOrPFC>(new_size);
+      root->remap(full_map, id_map);
+      first_empty = last_empty = free_ids_size = 0;
+    }
+
     std::string root_value()
     {
       return root->get_value();
@@ -638,6 +754,81 @@ namespace ring
       }
     }
 
+    /**
+     * @brief Renames the IDs of every leaf and points the new IDs to their leaves
+     *
+     * @param map New ID of every old ID
+     * @param id_map Reference to the vector that maps every new ID to its corresponding PFC
+     */
+    void remap(const std::vector<uint64_t> &map, std::vector<EmptyOrPFC> &id_map)
+    {
+      if (is_leaf())
+      {
+        if (pfc->size() == 0)
+          return;
+        pfc->remap_ids(map);
+        for (uint64_t id : pfc->all_ids())
+        {
+          id_map[id - 1].pfc = pfc;
+        }
+      }
+      else
+      {
+        left->remap(map, id_map);
+        right->remap(map, id_map);
+      }
+    }
+
+    /**
+     * @brief Searches the sorted values sorted[b, e) in the leaves of this subtree
+     *
+     * @param sorted Sorted values being searched
+     * @param b First value searched
+     * @param e End of the values searched
+     * @param ids Vector where the ID of sorted[i] is stored in ids[i]
+     */
+    void locate_batch(const std::vector<std::string> &sorted, uint64_t b, uint64_t e, std::vector<uint64_t> &ids)
+    {
+      if (is_leaf())
+      {
+        pfc->locate_batch(sorted, b, e, ids);
+        return;
+      }
+      // The values from the first word of the right subtree on go to the right
+      uint64_t m = std::lower_bound(sorted.begin() + b, sorted.begin() + e, pfc->first_word()) - sorted.begin();
+      if (b < m)
+        left->locate_batch(sorted, b, m, ids);
+      if (m < e)
+        right->locate_batch(sorted, m, e, ids);
+    }
+
+    /**
+     * @brief Searches the neighbours of a value that is not in this subtree
+     *
+     * @param val value being searched
+     * @param prev ID of the largest value smaller than val, 0 if there is none
+     * @param next ID of the smallest value greater than val, 0 if there is none
+     */
+    void neighbours(const std::string &val, uint64_t &prev, uint64_t &next)
+    {
+      if (is_leaf())
+      {
+        pfc->neighbours(val, prev, next);
+        return;
+      }
+      if (val.compare(pfc->first_word()) < 0)
+      {
+        left->neighbours(val, prev, next);
+        // The first word of the right subtree follows every word on the left
+        if (next == 0)
+          next = pfc->locate(pfc->first_word());
+      }
+      else
+      {
+        right->neighbours(val, prev, next);
+      }
+    }
+
     /**
      * @brief Search a value in the Binary Tree
      *
@@ -25,7 +25,11 @@
 #include <unordered_map>
 #include <vector>
 #include <utils.hpp>
+#include <stats_catalog.hpp>
+#include <plan_cache.hpp>
 #include <unordered_set>
+#include <algorithm>
+#include <limits>
 
 namespace ring {
 
@@ -120,10 +124,12 @@ namespace ring {
         public:
 
 
+            //! stats is not used, only interval sizes
             gao_size(const std::vector<triple_pattern>* triple_patterns,
                         const std::vector<ltj_iter_type>* iterators,
                         ring_type* r,
-                        std::vector<var_type> &gao){
+                        std::vector<var_type> &gao,
+                        const stats_catalog* stats = nullptr){
                 m_ptr_triple_patterns = triple_patterns;
                 m_ptr_iterators = iterators;
                 m_ptr_ring = r;
@@ -207,6 +213,307 @@ namespace ring {
                 //std::cout << "Done. " << std::endl;
             }
 
+            /**
+             * @brief GAO of a query whose shape is in plan. The same rules are applied
+             * to the interval sizes of its variables, without building var_info. The
+             * sizes depend on the constants of the query, so the order is decided again.
+             *
+             * @param vars  Variable of the query behind each variable of the plan
+             * @param sizes Smallest interval of each variable of the plan
+             * @return      Always true
+             */
+            template<class plan_t>
+            static bool from_plan(const plan_t &plan, const std::vector<var_type> &vars,
+                                  const std::vector<size_type> &sizes, std::vector<var_type> &gao){
+                const size_type n = plan.n_vars();
+                std::vector<size_type> order(n);
+                for(size_type v = 0; v < n; ++v) order[v] = v;
+                auto lonely = [&plan](const size_type v){ return plan.n_patterns(v) == 1; };
+                std::sort(order.begin(), order.end(), [&](const size_type a, const size_type b){
+                    if(lonely(a) != lonely(b)) return lonely(b);
+                    return sizes[a] < sizes[b];
+                });
+
+                std::vector<bool> checked(n, false);
+                gao.reserve(n);
+                for(const auto v : order){
+                    if(checked[v]) continue;
+                    gao.push_back(vars[v]);
+                    checked[v] = true;
+                    if(lonely(v)) continue;
+                    min_heap_type heap; //Related variables of the chosen ones
+                    size_type cur = v;
+                    while(true){
+                        for(const auto r : plan.related[cur]){
+                            if(!checked[r] && !lonely(r)){
+                                heap.push({sizes[r], (var_type) r});
+                                checked[r] = true;
+                            }
+                        }
+                        if(heap.empty()) break;
+                        cur = heap.top().second;
+                        heap.pop();
+                        gao.push_back(vars[cur]);
+                    }
+                }
+                return true;
+            }
+
+        };
+
+        /**
+         * @brief Cost-based GAO. For every pattern and variable it estimates the
+         * number of distinct values of the variable, by probing its first values
+         * with the iterator of the pattern: each probe is a leap, and the size of
+         * the pattern with that value bound gives its number of triples. The fan-out of binding a
+         * variable is the smallest estimate among its patterns, reduced by the
+         * variables of each pattern already bound. The order with the lowest sum of
+         * estimated intermediate results is searched by branch and bound over the
+         * related variables. Lonely variables go last, as in gao_size.
+         *
+         * With a stats_catalog, patterns with only their predicate fixed take the
+         * distinct subjects and objects from it, and the fan-out of a variable
+         * joining two such patterns is bounded by the number of nodes in the
+         * star or path join of their predicates.
+         */
+        template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t >
+        class gao_cost {
+
+        public:
+            typedef var_t var_type;
+            typedef cons_t cons_type;
+            typedef uint64_t size_type;
+            typedef ring_t ring_type;
+            typedef ltj_iterator<ring_type, var_type, cons_type> ltj_iter_type;
+
+            static const size_type probes = 16; // values probed per pattern and variable
+            static const size_type max_steps = 10000; // budget of the search of the order
+
+        private:
+            typedef struct {
+                double size;
+                std::vector<std::pair<var_type, double>> distinct;
+            } info_pattern_type;
+
+            const std::vector<triple_pattern>* m_ptr_triple_patterns;
+            const stats_catalog* m_stats;
+            std::vector<info_pattern_type> m_patterns;
+            std::unordered_map<var_type, std::vector<size_type>> m_var_patterns;
+            std::vector<var_type> m_related; // variables in more than one pattern
+            std::vector<bool> m_bound;
+            std::vector<var_type> m_order;
+            std::vector<var_type> m_best_order;
+            double m_best_cost;
+            size_type m_steps = 0;
+
+            //! Triples of triple with var = c; probe is its iterator, on the level of var
+            static size_type triples_of(const triple_pattern &triple, ltj_iter_type &probe, ring_type *r,
+                                        const var_type var, const cons_type c){
+                if(ltj_iter_type::exact_intervals){
+                    probe.down(var, c);
+                    size_type res = util::get_size_interval(probe);
+                    probe.up(var);
+                    return res;
+                }
+                //Rings whose intervals are not updated by down: a new iterator
+                triple_pattern bound = triple.bind(var, c);
+                ltj_iter_type iter_c(&bound, r);
+                return iter_c.is_empty ? 0 : util::get_size_interval(iter_c);
+            }
+
+            /**
+             * Estimated distinct values of var in triple, whose iterator is iter.
+             * The triples per value are sampled with probes spaced over the
+             * alphabet of var, from its first value in the pattern.
+             */
+            double estimate_distinct(const triple_pattern &triple, ltj_iter_type &iter, ring_type *r,
+                                     const var_type var, const size_type size){
+                if(iter.in_last_level()) return size; //one triple per value
+                if(m_stats != nullptr && !triple.p_is_variable()
+                   && triple.term_s.value != triple.term_o.value){ //?s p ?o
+                    return (triple.s_is_variable() && triple.term_s.value == var)
+                           ? m_stats->subjects(triple.term_p.value) : m_stats->objects(triple.term_p.value);
+                }
+                ltj_iter_type probe(iter); //down overwrites the intervals of the other variables
+                const cons_type first = probe.leap(var);
+                if(first == 0) return 0;
+                const size_type max = (triple.p_is_variable() && triple.term_p.value == var) ? r->max_p() : r->max_so();
+                const size_type step = max > first ? (max - first) / probes + 1 : 1;
+                size_type d = 0, covered = 0;
+                cons_type c = first;
+                while(c != 0 && d < probes){
+                    covered += triples_of(triple, probe, r, var, c);
+                    ++d;
+                    c = probe.leap(var, std::max<size_type>(c + 1, first + d * step));
+                }
+                if(c == 0 && step == 1) return d; //exact: every value was probed
+                if(covered == 0) return d;
+                return (double) size * d / covered;
+            }
+
+            //! Estimated values of var for each binding of the bound variables
+            double fan_out(const var_type var){
+                double res = -1;
+                for(size_type i : m_var_patterns[var]){
+                    const info_pattern_type &info = m_patterns[i];
+                    double est = info.size, d_var = info.size;
+                    for(const auto &e : info.distinct){
+                        if(e.first == var){
+                            d_var = e.second;
+                        }else if(m_bound[e.first] && e.second > 0){
+                            est /= e.second;
+                        }
+                    }
+                    if(d_var < est) est = d_var;
+                    if(res < 0 || est < res) res = est;
+                }
+                if(m_stats != nullptr){
+                    //Nodes in the star or path join of two patterns of var
+                    for(size_type i : m_var_patterns[var]){
+                        const triple_pattern &t_i = m_ptr_triple_patterns->at(i);
+                        if(t_i.p_is_variable()) continue;
+                        bool i_subject = t_i.s_is_variable() && t_i.term_s.value == var;
+                        bool i_object = t_i.o_is_variable() && t_i.term_o.value == var;
+                        for(size_type j : m_var_patterns[var]){
+                            const triple_pattern &t_j = m_ptr_triple_patterns->at(j);
+                            if(i == j || t_j.p_is_variable()) continue;
+                            if(!t_j.s_is_variable() || t_j.term_s.value != var) continue;
+                            double join = -1;
+                            if(i_object){
+                                join = m_stats->path(t_i.term_p.value, t_j.term_p.value);
+                            }else if(i_subject && i < j){
+                                join = m_stats->star(t_i.term_p.value, t_j.term_p.value);
+                            }
+                            if(join >= 0 && join < res) res = join;
+                        }
+                    }
+                }
+                return res;
+            }
+
+            bool is_related_to_bound(const var_type var){
+                for(size_type i : m_var_patterns[var]){
+                    for(const auto &e : m_patterns[i].distinct){
+                        if(e.first != var && m_bound[e.first]) return true;
+                    }
+                }
+                return false;
+            }
+
+            void search(const double n, const double cost){
+                if(cost >= m_best_cost) return;
+                if(m_order.size() == m_related.size()){
+                    m_best_cost = cost;
+                    m_best_order = m_order;
+                    return;
+                }
+                if(m_steps >= max_steps) return;
+                ++m_steps;
+
+                //Candidates: related to the bound variables if possible, cheapest first
+                std::vector<std::pair<double, var_type>> candidates;
+                bool connected = false;
+                for(const var_type var : m_related){
+                    if(m_bound[var]) continue;
+                    bool rel = is_related_to_bound(var);
+                    if(rel && !connected){
+                        candidates.clear();
+                        connected = true;
+                    }
+                    if(rel == connected){
+                        candidates.push_back({fan_out(var), var});
+                    }
+                }
+                std::sort(candidates.begin(), candidates.end());
+                for(const auto &cand : candidates){
+                    double n_next = n * cand.first;
+                    m_bound[cand.second] = true;
+                    m_order.push_back(cand.second);
+                    search(n_next, cost + n_next);
+                    m_order.pop_back();
+                    m_bound[cand.second] = false;
+                }
+            }
+
+        public:
+
+            gao_cost(const std::vector<triple_pattern>* triple_patterns,
+                     std::vector<ltj_iter_type>* iterators,
+                     ring_type* r,
+                     std::vector<var_type> &gao,
+                     const stats_catalog* stats = nullptr){
+                m_ptr_triple_patterns = triple_patterns;
+                m_stats = stats;
+
+                //1. Estimating the distinct values of each variable in each pattern
+                std::unordered_map<var_type, size_type> occurrences;
+                std::vector<std::pair<size_type, var_type>> lonely;
+                m_patterns.resize(triple_patterns->size());
+                size_type max_var = 0;
+                for(size_type i = 0; i < triple_patterns->size(); ++i){
+                    const triple_pattern &triple = triple_patterns->at(i);
+                    ltj_iter_type &iter = iterators->at(i);
+                    size_type size = util::get_size_interval(iter);
+                    m_patterns[i].size = size;
+                    std::vector<var_type> vars;
+                    if(triple.s_is_variable()) vars.push_back((var_type) triple.term_s.value);
+                    if(triple.p_is_variable()) vars.push_back((var_type) triple.term_p.value);
+                    if(triple.o_is_variable()) vars.push_back((var_type) triple.term_o.value);
+                    for(size_type k = 0; k < vars.size(); ++k){
+                        var_type var = vars[k];
+                        ++occurrences[var];
+                        if(var > max_var) max_var = var;
+                        if(std::find(vars.begin(), vars.begin() + k, var) != vars.begin() + k) continue;
+                        m_patterns[i].distinct.push_back({var, estimate_distinct(triple, iter, r, var, size)});
+                        m_var_patterns[var].push_back(i);
+                    }
+                }
+
+                //2. Lonely variables are sorted by size and go last
+                for(const auto &e : occurrences){
+                    if(e.second > 1){
+                        m_related.push_back(e.first);
+                    }else{
+                        lonely.push_back({(size_type) m_patterns[m_var_patterns[e.first][0]].size, e.first});
+                    }
+                }
+                std::sort(m_related.begin(), m_related.end());
+                std::sort(lonely.begin(), lonely.end());
+
+                //3. Choosing the order of the related variables
+                m_bound.assign(max_var + 1, false);
+                m_best_cost = std::numeric_limits<double>::infinity();
+                search(1, 0);
+                gao = m_best_order;
+                for(const auto &e : lonely){
+                    gao.push_back(e.second);
+                }
+            }
+
+            /**
+             * @brief GAO of a query whose shape is in plan. The search is too costly
+             * to repeat, so the GAO of the plan is reused while the constants of the
+             * query keep the interval sizes of its variables in the same order as
+             * in the planned query. Otherwise the query has to be planned again.
+             *
+             * @param vars  Variable of the query behind each variable of the plan
+             * @param sizes Smallest interval of each variable of the plan
+             * @return      False if the GAO of the plan cannot be reused
+             */
+            template<class plan_t>
+            static bool from_plan(const plan_t &plan, const std::vector<var_type> &vars,
+                                  const std::vector<size_type> &sizes, std::vector<var_type> &gao){
+                const size_type n = plan.n_vars();
+                for(size_type a = 0; a < n; ++a){
+                    for(size_type b = 0; b < n; ++b){
+                        if(plan.sizes[a] < plan.sizes[b] && sizes[a] > sizes[b]) return false;
+                    }
+                }
+                gao.reserve(plan.gao.size());
+                for(const auto v : plan.gao) gao.push_back(vars[v]);
+                return true;
+            }
+
         };
 
     }
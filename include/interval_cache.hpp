@@ -0,0 +1,183 @@
+/*
+ * interval_cache.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_INTERVAL_CACHE_HPP
+#define RING_INTERVAL_CACHE_HPP
+
+#include <array>
+#include <list>
+#include <unordered_map>
+#include "bwt_interval.hpp"
+#include <triple_pattern.hpp>
+
+namespace ring {
+
+    /**
+     * @brief LRU cache of the initial state of the iterators, keyed by the
+     * constants of their triple patterns. The iterators of a pattern whose
+     * constants were already resolved, such as a popular predicate or a hub
+     * entity, copy its intervals instead of descending the wavelet matrices.
+     *
+     * The entries describe one ring: the cache has to be cleared when the ring
+     * is updated in place.
+     */
+    class interval_cache {
+
+    public:
+        typedef uint64_t size_type;
+        typedef std::array<uint64_t, 3> key_type; // constants of S, P and O; -1 for variables
+
+        struct entry_type {
+            bwt_interval i_s;
+            bwt_interval i_p;
+            bwt_interval i_o;
+            uint64_t cur_s;
+            uint64_t cur_p;
+            uint64_t cur_o;
+            bool is_empty;
+        };
+
+    private:
+        struct hash_key {
+            size_t operator()(const key_type &k) const {
+                uint64_t h = k[0] * 0x9E3779B97F4A7C15ULL;
+                h = (h ^ (h >> 29) ^ k[1]) * 0xBF58476D1CE4E5B9ULL;
+                h = (h ^ (h >> 32) ^ k[2]) * 0x94D049BB133111EBULL;
+                return h ^ (h >> 31);
+            }
+        };
+
+        typedef std::list<std::pair<key_type, entry_type>> list_type;
+        typedef std::unordered_map<key_type, list_type::iterator, hash_key> index_type;
+
+        list_type m_lru; // most recently used first
+        index_type m_index;
+        size_type m_capacity;
+        size_type m_hits = 0;
+        size_type m_misses = 0;
+
+        void copy(const interval_cache &o) {
+            m_lru = o.m_lru;
+            m_index.clear();
+            for (auto it = m_lru.begin(); it != m_lru.end(); ++it) {
+                m_index[it->first] = it;
+            }
+            m_capacity = o.m_capacity;
+            m_hits = o.m_hits;
+            m_misses = o.m_misses;
+        }
+
+    public:
+
+        //! Up to capacity entries are kept
+        interval_cache(const size_type capacity = 65536) : m_capacity(capacity) {}
+
+        //! Copy constructor
+        interval_cache(const interval_cache &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        interval_cache(interval_cache &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        interval_cache &operator=(const interval_cache &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        interval_cache &operator=(interval_cache &&o) {
+            if (this != &o) {
+                m_lru = std::move(o.m_lru);
+                m_index = std::move(o.m_index);
+                m_capacity = o.m_capacity;
+                m_hits = o.m_hits;
+                m_misses = o.m_misses;
+            }
+            return *this;
+        }
+
+        void swap(interval_cache &o) {
+            std::swap(m_lru, o.m_lru);
+            std::swap(m_index, o.m_index);
+            std::swap(m_capacity, o.m_capacity);
+            std::swap(m_hits, o.m_hits);
+            std::swap(m_misses, o.m_misses);
+        }
+
+        static key_type key(const triple_pattern &triple) {
+            return {triple.s_is_variable() ? (uint64_t) -1 : triple.term_s.value,
+                    triple.p_is_variable() ? (uint64_t) -1 : triple.term_p.value,
+                    triple.o_is_variable() ? (uint64_t) -1 : triple.term_o.value};
+        }
+
+        //! Entry of key, or nullptr if it is not cached
+        const entry_type *find(const key_type &key) {
+            auto it = m_index.find(key);
+            if (it == m_index.end()) {
+                ++m_misses;
+                return nullptr;
+            }
+            ++m_hits;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return &it->second->second;
+        }
+
+        //! Caches the entry of key, evicting the least recently used one if the cache is full
+        void insert(const key_type &key, const entry_type &entry) {
+            auto it = m_index.find(key);
+            if (it != m_index.end()) {
+                it->second->second = entry;
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                return;
+            }
+            if (m_capacity == 0) return;
+            if (m_lru.size() >= m_capacity) {
+                m_index.erase(m_lru.back().first);
+                m_lru.pop_back();
+            }
+            m_lru.emplace_front(key, entry);
+            m_index[key] = m_lru.begin();
+        }
+
+        void clear() {
+            m_lru.clear();
+            m_index.clear();
+        }
+
+        inline size_type size() const {
+            return m_lru.size();
+        }
+
+        inline size_type hits() const {
+            return m_hits;
+        }
+
+        inline size_type misses() const {
+            return m_misses;
+        }
+    };
+}
+
+#endif
@@ -27,10 +27,16 @@
 #include <ring.hpp>
 #include <ltj_iterator.hpp>
 #include <gao.hpp>
+#include <plan_cache.hpp>
+#include <cancel_token.hpp>
+#include <semi_join.hpp>
+#include <queue>
+#include <algorithm>
 
 namespace ring {
 
-    template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t>
+    template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t,
+             class gao_t = gao::gao_size<ring_t, var_t, cons_t>>
     class ltj_algorithm {
 
     public:
@@ -40,17 +46,34 @@ namespace ring {
         typedef ring_t ring_type;
         typedef cons_t const_type;
         typedef ltj_iterator<ring_type, var_type, const_type> ltj_iter_type;
-        typedef std::unordered_map<var_type, std::vector<ltj_iter_type*>> var_to_iterators_type;
+        typedef gao_t gao_type;
+        typedef plan_cache<var_type> plan_cache_type;
+        typedef semi_join<ring_type, var_type, const_type> semi_join_type;
+        typedef typename semi_join_type::bitmap_type bitmap_type;
         typedef std::vector<std::pair<var_type, value_type>> tuple_type;
-        typedef std::chrono::high_resolution_clock::time_point time_point_type;
 
     private:
         const std::vector<triple_pattern>* m_ptr_triple_patterns;
         std::vector<var_type> m_gao; //TODO: should be a class
         ring_type* m_ptr_ring;
         std::vector<ltj_iter_type> m_iterators;
-        var_to_iterators_type m_var_to_iterators;
+        std::vector<size_type> m_var_begin; //First entry of each variable in m_var_iterators
+        std::vector<ltj_iter_type*> m_var_iterators; //Iterators of each variable, one after the other
         bool m_is_empty = false;
+        bool m_adaptive = false;
+        size_type m_n_fixed = 0; //Leading variables of m_gao not moved by the adaptive mode
+        std::vector<bitmap_type> m_candidates; //Candidates of each variable after semi_join_reduce, empty if none
+
+        struct var_filter_type {
+            value_type lower = 0; //Range of the values, both included
+            value_type upper = -1;
+            std::vector<value_type> excluded; //Constants of the != filters
+            std::vector<std::pair<filter_pattern::op_type, var_type>> compared; //Filters with other variables
+        };
+        std::vector<triple_pattern> m_bound_patterns; //Triple patterns with the variables of the = filters bound
+        tuple_type m_constants; //Variables of the = filters and their values
+        std::vector<var_filter_type> m_var_filters; //FILTERs of each variable, empty if there are none
+        std::vector<value_type> m_values; //Current value of each variable when there are FILTERs, 0 if unbound
 
 
         void copy(const ltj_algorithm &o) {
@@ -58,18 +81,230 @@ namespace ring {
             m_gao = o.m_gao;
             m_ptr_ring = o.m_ptr_ring;
             m_iterators = o.m_iterators;
-            m_var_to_iterators = o.m_var_to_iterators;
+            m_var_begin = o.m_var_begin;
+            m_var_iterators.resize(o.m_var_iterators.size());
+            for(size_type k = 0; k < m_var_iterators.size(); ++k){ //Pointing to our iterators
+                m_var_iterators[k] = &m_iterators[o.m_var_iterators[k] - o.m_iterators.data()];
+            }
             m_is_empty = o.m_is_empty;
+            m_adaptive = o.m_adaptive;
+            m_n_fixed = o.m_n_fixed;
+            m_candidates = o.m_candidates;
+            m_bound_patterns = o.m_bound_patterns;
+            if(o.m_ptr_triple_patterns == &o.m_bound_patterns) m_ptr_triple_patterns = &m_bound_patterns;
+            m_constants = o.m_constants;
+            m_var_filters = o.m_var_filters;
+            m_values = o.m_values;
         }
 
+        //! Iterators of a variable
+        struct iterators_range {
+            ltj_iter_type* const* first;
+            ltj_iter_type* const* last;
 
-        inline void add_var_to_iterator(const var_type var, ltj_iter_type* ptr_iterator){
-            auto it =  m_var_to_iterators.find(var);
-            if(it != m_var_to_iterators.end()){
-                it->second.push_back(ptr_iterator);
-            }else{
-                std::vector<ltj_iter_type*> vec = {ptr_iterator};
-                m_var_to_iterators.insert({var, vec});
+            inline ltj_iter_type* const* begin() const { return first; }
+            inline ltj_iter_type* const* end() const { return last; }
+            inline size_type size() const { return last - first; }
+            inline ltj_iter_type* operator[](const size_type i) const { return first[i]; }
+        };
+
+        //! Iterators of var, none if it is not in the query
+        inline iterators_range iterators_of(const var_type var) const {
+            if((size_type) var + 1 >= m_var_begin.size()) return {nullptr, nullptr};
+            ltj_iter_type* const* base = m_var_iterators.data();
+            return {base + m_var_begin[var], base + m_var_begin[var + 1]};
+        }
+
+        inline bool has_candidates(const var_type x_j) const {
+            return x_j < m_candidates.size() && m_candidates[x_j].size() > 0;
+        }
+
+        //! Value of var in an = filter, 0 if there is none
+        value_type constant_of(const uint64_t var) const {
+            for(const auto &e : m_constants){
+                if(e.first == var) return e.second;
+            }
+            return 0;
+        }
+
+        //! True if c passes the FILTERs of x_j and is one of its candidates
+        inline bool accept(const var_type x_j, const value_type c) const {
+            if(has_candidates(x_j) && !semi_join_type::contains(m_candidates[x_j], c)) return false;
+            if(x_j >= m_var_filters.size()) return true;
+            const var_filter_type &f = m_var_filters[x_j];
+            if(c < f.lower || c > f.upper) return false;
+            for(const auto v : f.excluded){
+                if(v == c) return false;
+            }
+            for(const auto &e : f.compared){
+                if(m_values[e.second] != 0 && !filter_pattern::holds(e.first, c, m_values[e.second])) return false;
+            }
+            return true;
+        }
+
+        /**
+         * Adds the FILTERs of the query. The variables of the = filters become
+         * constants of the triple patterns, and the other filters are checked
+         * by seek. Returns false if the filters cannot hold. A filter on a
+         * variable that is not in the patterns is an error in SPARQL, so it is
+         * false.
+         */
+        bool add_filters(const std::vector<filter_pattern> &filters){
+            uint64_t max_var = 0;
+            for(const auto &triple : *m_ptr_triple_patterns){
+                if(triple.s_is_variable()) max_var = std::max(max_var, triple.term_s.value);
+                if(triple.p_is_variable()) max_var = std::max(max_var, triple.term_p.value);
+                if(triple.o_is_variable()) max_var = std::max(max_var, triple.term_o.value);
+            }
+            std::vector<bool> bound(max_var + 1, false);
+            for(const auto &triple : *m_ptr_triple_patterns){
+                if(triple.s_is_variable()) bound[triple.term_s.value] = true;
+                if(triple.p_is_variable()) bound[triple.term_p.value] = true;
+                if(triple.o_is_variable()) bound[triple.term_o.value] = true;
+            }
+            auto is_bound = [&bound](const uint64_t var) {
+                return var < bound.size() && bound[var];
+            };
+            for(const auto &f : filters){
+                if(!is_bound(f.var) || (f.term.is_variable && !is_bound(f.term.value))) return false;
+            }
+            for(const auto &f : filters){
+                if(f.op != filter_pattern::equal || f.term.is_variable) continue;
+                value_type c = constant_of(f.var);
+                if(c != 0 && c != f.term.value) return false;
+                if(c == 0) m_constants.emplace_back((var_type) f.var, f.term.value);
+            }
+            auto var_filter = [this, max_var](const uint64_t var) -> var_filter_type& {
+                if(m_var_filters.empty()) {
+                    m_var_filters.resize(max_var + 1);
+                    m_values.resize(max_var + 1, 0);
+                }
+                return m_var_filters[var];
+            };
+            for(const auto &f : filters){
+                if(f.op == filter_pattern::equal && !f.term.is_variable) continue;
+                uint64_t var = f.var;
+                filter_pattern::op_type op = f.op;
+                value_type c = constant_of(var), k = f.term.value;
+                if(f.term.is_variable){ //?var op ?other
+                    value_type d = constant_of(f.term.value);
+                    if(c != 0 && d != 0){
+                        if(!filter_pattern::holds(op, c, d)) return false;
+                        continue;
+                    }else if(c != 0){ //?other mirror(op) c
+                        var = f.term.value;
+                        op = filter_pattern::mirror(op);
+                        k = c;
+                    }else if(d != 0){
+                        k = d;
+                    }else{
+                        if(var == f.term.value){
+                            if(!filter_pattern::holds(op, 1, 1)) return false;
+                        }else{
+                            var_filter(var).compared.emplace_back(op, (var_type) f.term.value);
+                            var_filter(f.term.value).compared.emplace_back(filter_pattern::mirror(op), (var_type) var);
+                        }
+                        continue;
+                    }
+                }else if(c != 0){ //The variable is a constant: the filter is true or false
+                    if(!filter_pattern::holds(op, c, k)) return false;
+                    continue;
+                }
+                var_filter_type &vf = var_filter(var);
+                switch(op){
+                    case filter_pattern::equal: vf.lower = std::max(vf.lower, k); vf.upper = std::min(vf.upper, k); break;
+                    case filter_pattern::not_equal: vf.excluded.push_back(k); break;
+                    case filter_pattern::less: if(k == 0) return false; vf.upper = std::min(vf.upper, k - 1); break;
+                    case filter_pattern::less_equal: vf.upper = std::min(vf.upper, k); break;
+                    case filter_pattern::greater: vf.lower = std::max(vf.lower, k + 1); break;
+                    default: vf.lower = std::max(vf.lower, k); break;
+                }
+                if(vf.lower > vf.upper) return false;
+            }
+            if(!m_constants.empty()){
+                m_bound_patterns = *m_ptr_triple_patterns;
+                for(auto &triple : m_bound_patterns){
+                    for(const auto &e : m_constants) triple = triple.bind(e.first, e.second);
+                }
+                m_ptr_triple_patterns = &m_bound_patterns;
+            }
+            return true;
+        }
+
+        //! Tuple of a search, with the variables of the = filters at the end
+        tuple_type new_tuple() const {
+            tuple_type t(m_gao.size());
+            t.insert(t.end(), m_constants.begin(), m_constants.end());
+            return t;
+        }
+
+
+        /**
+         * Moves to position j the unbound variable (m_gao[j..]) with the smallest
+         * interval among its iterators, given the bindings of m_gao[0..j).
+         * Lonely variables go last, as in the initial GAO.
+         */
+        void choose_next(const size_type j){
+            size_type best = j, best_weight = UINT64_MAX;
+            bool best_lonely = true;
+            for(size_type k = j; k < m_gao.size(); ++k){
+                iterators_range itrs = iterators_of(m_gao[k]);
+                bool lonely = itrs.size() == 1;
+                if(lonely && !best_lonely) continue;
+                size_type weight = UINT64_MAX;
+                for(ltj_iter_type* iter : itrs){
+                    size_type size = util::get_size_interval(*iter);
+                    if(size < weight) weight = size;
+                }
+                if((best_lonely && !lonely) || weight < best_weight){
+                    best = k;
+                    best_weight = weight;
+                    best_lonely = lonely;
+                }
+            }
+            std::swap(m_gao[j], m_gao[best]);
+        }
+
+        //! Pointers to the iterators of each variable, in the order o, p, s of every pattern
+        void wire_iterators(){
+            size_type n_vars = 0;
+            for(const auto& triple : *m_ptr_triple_patterns){
+                if(triple.o_is_variable()) n_vars = std::max<size_type>(n_vars, triple.term_o.value + 1);
+                if(triple.p_is_variable()) n_vars = std::max<size_type>(n_vars, triple.term_p.value + 1);
+                if(triple.s_is_variable()) n_vars = std::max<size_type>(n_vars, triple.term_s.value + 1);
+            }
+            m_var_begin.assign(n_vars + 1, 0);
+            for(const auto& triple : *m_ptr_triple_patterns){
+                if(triple.o_is_variable()) ++m_var_begin[triple.term_o.value + 1];
+                if(triple.p_is_variable()) ++m_var_begin[triple.term_p.value + 1];
+                if(triple.s_is_variable()) ++m_var_begin[triple.term_s.value + 1];
+            }
+            for(size_type v = 1; v <= n_vars; ++v) m_var_begin[v] += m_var_begin[v - 1];
+            m_var_iterators.resize(m_var_begin[n_vars]);
+            std::vector<size_type> next(m_var_begin.begin(), m_var_begin.end() - 1);
+            size_type i = 0;
+            for(const auto& triple : *m_ptr_triple_patterns){
+                if(triple.o_is_variable()) m_var_iterators[next[triple.term_o.value]++] = &(m_iterators[i]);
+                if(triple.p_is_variable()) m_var_iterators[next[triple.term_p.value]++] = &(m_iterators[i]);
+                if(triple.s_is_variable()) m_var_iterators[next[triple.term_s.value]++] = &(m_iterators[i]);
+                ++i;
+            }
+        }
+
+        //! Same wiring as wire_iterators, taken from the plan of the shape of the query
+        template<class plan_t>
+        void wire_iterators(const plan_t &plan, const std::vector<var_type> &vars){
+            size_type n_vars = 0;
+            for(const auto var : vars) n_vars = std::max<size_type>(n_vars, var + 1);
+            m_var_begin.assign(n_vars + 1, 0);
+            for(size_type v = 0; v < vars.size(); ++v) m_var_begin[vars[v] + 1] = plan.n_patterns(v);
+            for(size_type v = 1; v <= n_vars; ++v) m_var_begin[v] += m_var_begin[v - 1];
+            m_var_iterators.resize(m_var_begin[n_vars]);
+            for(size_type v = 0; v < vars.size(); ++v){
+                size_type pos = m_var_begin[vars[v]];
+                for(size_type e = plan.wiring_begin[v]; e < plan.wiring_begin[v + 1]; ++e){
+                    m_var_iterators[pos++] = &(m_iterators[plan.wiring[e]]);
+                }
             }
         }
 
@@ -78,35 +313,73 @@ namespace ring {
 
         ltj_algorithm() = default;
 
-        ltj_algorithm(const std::vector<triple_pattern>* triple_patterns, ring_type* ring){
+        /**
+         *
+         * @param triple_patterns   Triple patterns of the query
+         * @param ring              Index
+         * @param adaptive          If true, the next variable is chosen during the search from the
+         *                          current intervals, instead of following the initial GAO
+         * @param stats             (Optional) Statistics of the ring, used by the GAO
+         * @param cache             (Optional) Plans of the previous queries. A cache has to be
+         *                          used with only one type of GAO
+         * @param intervals         (Optional) Initial states of the iterators of previous queries
+         * @param filters           (Optional) FILTERs of the query, evaluated by seek
+         */
+        ltj_algorithm(const std::vector<triple_pattern>* triple_patterns, ring_type* ring,
+                      const bool adaptive = false, const stats_catalog* stats = nullptr,
+                      plan_cache_type* cache = nullptr, interval_cache* intervals = nullptr,
+                      const std::vector<filter_pattern>* filters = nullptr){
 
             m_ptr_triple_patterns = triple_patterns;
             m_ptr_ring = ring;
+            m_adaptive = adaptive;
+            if(filters != nullptr && !add_filters(*filters)){
+                m_is_empty = true;
+                return;
+            }
+
+            std::vector<var_type> vars;
+            const typename plan_cache_type::plan_type* plan = nullptr;
+            if(cache != nullptr){
+                plan = cache->find(*m_ptr_triple_patterns, vars);
+            }
 
             size_type i = 0;
             m_iterators.resize(m_ptr_triple_patterns->size());
             for(const auto& triple : *m_ptr_triple_patterns){
                 //Bulding iterators
-                m_iterators[i] = ltj_iter_type(&triple, m_ptr_ring);
+                m_iterators[i] = ltj_iter_type(&triple, m_ptr_ring, intervals);
                 if(m_iterators[i].is_empty){
                     m_is_empty = true;
                     return;
                 }
-
-                //For each variable we add the pointers to its iterators
-                if(triple.o_is_variable()){
-                    add_var_to_iterator(triple.term_o.value, &(m_iterators[i]));
-                }
-                if(triple.p_is_variable()){
-                    add_var_to_iterator(triple.term_p.value, &(m_iterators[i]));
-                }
-                if(triple.s_is_variable()){
-                    add_var_to_iterator(triple.term_s.value, &(m_iterators[i]));
-                }
+                m_iterators[i].keep_intervals(m_adaptive);
                 ++i;
             }
 
-            gao::gao_size<ring_type> gao_sv2(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao);
+            //For each variable we add the pointers to its iterators
+            if(plan != nullptr){
+                wire_iterators(*plan, vars);
+            }else{
+                wire_iterators();
+            }
+            if(cache == nullptr){
+                gao_type planner(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao, stats);
+                return;
+            }
+
+            std::vector<size_type> sizes(vars.size(), UINT64_MAX);
+            for(size_type v = 0; v < vars.size(); ++v){
+                for(ltj_iter_type* iter : iterators_of(vars[v])){
+                    size_type size = util::get_size_interval(*iter);
+                    if(size < sizes[v]) sizes[v] = size;
+                }
+            }
+            //Known shape: the GAO is decided with its plan, unless the plan does not fit the query
+            if(plan != nullptr && gao_type::from_plan(*plan, vars, sizes, m_gao)) return;
+            m_gao.clear();
+            gao_type planner(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao, stats);
+            cache->insert(vars, *m_ptr_triple_patterns, m_gao, sizes);
 
         }
 
@@ -135,8 +408,17 @@ namespace ring {
                 m_gao = std::move(o.m_gao);
                 m_ptr_ring = std::move(o.m_ptr_ring);
                 m_iterators = std::move(o.m_iterators);
-                m_var_to_iterators = std::move(o.m_var_to_iterators);
+                m_var_begin = std::move(o.m_var_begin);
+                m_var_iterators = std::move(o.m_var_iterators);
                 m_is_empty = o.m_is_empty;
+                m_adaptive = o.m_adaptive;
+                m_n_fixed = o.m_n_fixed;
+                m_candidates = std::move(o.m_candidates);
+                m_bound_patterns = std::move(o.m_bound_patterns);
+                if(o.m_ptr_triple_patterns == &o.m_bound_patterns) m_ptr_triple_patterns = &m_bound_patterns;
+                m_constants = std::move(o.m_constants);
+                m_var_filters = std::move(o.m_var_filters);
+                m_values = std::move(o.m_values);
             }
             return *this;
         }
@@ -146,8 +428,35 @@ namespace ring {
             std::swap(m_gao, o.m_gao);
             std::swap(m_ptr_ring, o.m_ptr_ring);
             std::swap(m_iterators, o.m_iterators);
-            std::swap(m_var_to_iterators, o.m_var_to_iterators);
+            std::swap(m_var_begin, o.m_var_begin);
+            std::swap(m_var_iterators, o.m_var_iterators);
             std::swap(m_is_empty, o.m_is_empty);
+            std::swap(m_adaptive, o.m_adaptive);
+            std::swap(m_n_fixed, o.m_n_fixed);
+            std::swap(m_candidates, o.m_candidates);
+            std::swap(m_bound_patterns, o.m_bound_patterns);
+            if(m_ptr_triple_patterns == &o.m_bound_patterns) m_ptr_triple_patterns = &m_bound_patterns;
+            if(o.m_ptr_triple_patterns == &m_bound_patterns) o.m_ptr_triple_patterns = &o.m_bound_patterns;
+            std::swap(m_constants, o.m_constants);
+            std::swap(m_var_filters, o.m_var_filters);
+            std::swap(m_values, o.m_values);
+        }
+
+        /**
+         * @brief Semi-join reduction of an acyclic query before the join (see semi_join.hpp).
+         * The candidates of each variable restrict the values tried by seek.
+         * @return  False if the query is not acyclic and it was not reduced
+         */
+        bool semi_join_reduce(){
+            if(m_is_empty) return true;
+            semi_join_type reduction(m_ptr_triple_patterns, m_ptr_ring);
+            if(!reduction.acyclic()) return false;
+            if(reduction.empty()) {
+                m_is_empty = true;
+            }else{
+                m_candidates = std::move(reduction.candidates());
+            }
+            return true;
         }
 
 
@@ -159,10 +468,87 @@ namespace ring {
         */
         void join(std::vector<tuple_type> &res,
                   const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            join(res, limit_results, token);
+        };
+
+        /**
+        *
+        * @param res               Results
+        * @param limit_results     Limit of results
+        * @param token             Stops the join at its deadline or when it is cancelled
+        */
+        void join(std::vector<tuple_type> &res, const size_type limit_results, cancel_token &token){
             if(m_is_empty) return;
-            time_point_type start = std::chrono::high_resolution_clock::now();
-            tuple_type t(m_gao.size());
-            search(0, t, res, start, limit_results, timeout_seconds);
+            tuple_type t = new_tuple();
+            search(0, t, res, token, limit_results);
+        };
+
+        /**
+         * @brief Reports the results one by one instead of storing them
+         * @param report            Called as report(tuple) with each result. The join stops when it returns false
+         * @param token             Stops the join at its deadline or when it is cancelled
+         * @return                  False if the join was stopped
+         */
+        template<class report_t>
+        bool join_report(report_t &report, cancel_token &token){
+            if(m_is_empty) return true;
+            tuple_type t = new_tuple();
+            return search_report(0, t, report, token);
+        };
+
+        /**
+         * @brief First k results ordered by the value of var (ORDER BY var LIMIT k).
+         *
+         * LTJ binds every variable in increasing order, so when var leads the GAO
+         * the results come sorted and the join stops after k of them. The rest of
+         * the GAO keeps its order, and the adaptive mode does not move var. In
+         * descending order, or when var is a lonely variable of a pattern without
+         * other variables (its values come from seek_all, unsorted), all the
+         * results are visited keeping the best k in a bounded heap.
+         *
+         * @param res               Results, sorted by var
+         * @param var               Variable of the order
+         * @param k                 Number of results
+         * @param descending        Decreasing order
+         * @param timeout_seconds   Timeout in seconds
+         */
+        void join_top_k(std::vector<tuple_type> &res, const var_type var, const size_type k,
+                        const bool descending = false, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            join_top_k(res, var, k, descending, token);
+        };
+
+        //! join_top_k stopped by a cancel_token
+        void join_top_k(std::vector<tuple_type> &res, const var_type var, const size_type k,
+                        const bool descending, cancel_token &token){
+            if(m_is_empty || k == 0) return;
+            iterators_range itrs = iterators_of(var);
+            if(itrs.size() == 0){ //Not in the query: any k results
+                join(res, k, token);
+                return;
+            }
+            tuple_type t = new_tuple();
+
+            if(!descending && !(itrs.size() == 1 && itrs[0]->in_last_level())){
+                //var leads the GAO
+                std::vector<var_type> gao = m_gao;
+                auto pos = std::find(m_gao.begin(), m_gao.end(), var);
+                std::rotate(m_gao.begin(), pos, pos + 1);
+                m_n_fixed = 1;
+                search(0, t, res, token, k);
+                m_n_fixed = 0;
+                m_gao = std::move(gao);
+                return;
+            }
+
+            util::top_k_heap<tuple_type, var_type> heap(var, k, descending);
+            auto report = [&heap](const tuple_type &tuple){
+                heap.push(tuple);
+                return true;
+            };
+            search_report(0, t, report, token);
+            heap.pop_all(res);
         };
 
 
@@ -171,57 +557,74 @@ namespace ring {
          * @param j                 Index of the variable
          * @param tuple             Tuple of the current search
          * @param res               Results
-         * @param start             Initial time to check timeout
+         * @param token             Stops the search at its deadline or when it is cancelled
          * @param limit_results     Limit of results
-         * @param timeout_seconds   Timeout in seconds
          */
         bool search(const size_type j, tuple_type &tuple, std::vector<tuple_type> &res,
-                    const time_point_type start,
-                    const size_type limit_results = 0, const size_type timeout_seconds = 0){
-
-            //(Optional) Check timeout
-            if(timeout_seconds > 0){
-                time_point_type stop = std::chrono::high_resolution_clock::now();
-                auto sec = std::chrono::duration_cast<std::chrono::seconds>(stop-start).count();
-                if(sec > timeout_seconds) return false;
-            }
+                    cancel_token &token, const size_type limit_results = 0){
 
             //(Optional) Check limit
             if(limit_results > 0 && res.size() == limit_results) return false;
 
+            auto report = [&res, limit_results](const tuple_type &t){
+                res.emplace_back(t);
+                return limit_results == 0 || res.size() < limit_results;
+            };
+            return search_report(j, tuple, report, token);
+        };
+
+        /**
+         *
+         * @param j                 Index of the variable
+         * @param tuple             Tuple of the current search
+         * @param report            Called as report(tuple) with each result. The search stops when it returns false
+         * @param token             Stops the search at its deadline or when it is cancelled
+         */
+        template<class report_t>
+        bool search_report(const size_type j, tuple_type &tuple, report_t &report, cancel_token &token){
+
+            //Check timeout and cancellation
+            if(token.stop()) return false;
 
             if(j == m_gao.size()){
                 //Report results
-                res.emplace_back(tuple);
+                return report(tuple);
             }else{
+                //(Optional) The order of m_gao[j..] is only decided here
+                if(m_adaptive && j >= m_n_fixed) choose_next(j);
                 var_type x_j = m_gao[j];
-                std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[x_j];
+                iterators_range itrs = iterators_of(x_j);
                 bool ok;
                 if(itrs.size() == 1 && itrs[0]->in_last_level()) {//Lonely variables
                     auto results = itrs[0]->seek_all(x_j);
+                    bool check = has_candidates(x_j) || x_j < m_var_filters.size();
                     for (const auto &c : results) {
+                        if(check && !accept(x_j, c)) continue;
                         //1. Adding result to tuple
                         tuple[j] = {x_j, c};
+                        if(!m_values.empty()) m_values[x_j] = c;
                         //2. Going down in the trie by setting x_j = c (\mu(t_i) in paper)
                         itrs[0]->down(x_j, c);
                         //2. Search with the next variable x_{j+1}
-                        ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
+                        ok = search_report(j + 1, tuple, report, token);
                         if(!ok) return false;
                         //4. Going up in the trie by removing x_j = c
                         itrs[0]->up(x_j);
                     }
+                    if(!m_values.empty()) m_values[x_j] = 0;
                 }else {
                     value_type c = seek(x_j);
                     //std::cout << "Seek (init): (" << (uint64_t) x_j << ": " << c << ")" <<std::endl;
                     while (c != 0) { //If empty c=0
                         //1. Adding result to tuple
                         tuple[j] = {x_j, c};
+                        if(!m_values.empty()) m_values[x_j] = c;
                         //2. Going down in the tries by setting x_j = c (\mu(t_i) in paper)
                         for (ltj_iter_type* iter : itrs) {
                             iter->down(x_j, c);
                         }
                         //3. Search with the next variable x_{j+1}
-                        ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
+                        ok = search_report(j + 1, tuple, report, token);
                         if(!ok) return false;
                         //4. Going up in the tries by removing x_j = c
                         for (ltj_iter_type *iter : itrs) {
@@ -231,6 +634,7 @@ namespace ring {
                         c = seek(x_j, c + 1);
                         // std::cout << "Seek (bucle): (" << (uint64_t) x_j << ": " << c << ")" <<std::endl;
                     }
+                    if(!m_values.empty()) m_values[x_j] = 0;
                 }
             }
             return true;
@@ -246,8 +650,14 @@ namespace ring {
          */
 
         value_type seek(const var_type x_j, value_type c=-1){
-            value_type c_i, c_min = UINT64_MAX, c_max = 0;
-            std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[x_j];
+            value_type c_i, c_min = UINT64_MAX, c_max = 0, upper = -1;
+            iterators_range itrs = iterators_of(x_j);
+            if(x_j < m_var_filters.size()){
+                //The range of x_j clamps the start and the end of the leaps
+                const var_filter_type &f = m_var_filters[x_j];
+                if(c == -1 || c < f.lower) c = f.lower > 0 ? f.lower : c;
+                upper = f.upper;
+            }
             while (true){
                 //Compute leap for each triple that contains x_j
                 for(ltj_iter_type* iter : itrs){
@@ -256,14 +666,22 @@ namespace ring {
                     }else{
                         c_i = iter->leap(x_j, c);
                     }
-                    if(c_i == 0) {
+                    if(c_i == 0 || c_i > upper) {
                         return 0; //Empty intersection
                     }
                     if(c_i > c_max) c_max = c_i;
                     if(c_i < c_min) c_min = c_i;
                     c = c_max;
                 }
-                if(c_min == c_max) return c_min;
+                if(c_min == c_max){
+                    if(accept(x_j, c_min)) return c_min;
+                    c = c_min + 1; //Skips a value discarded by the FILTERs or the semi-join reduction
+                }
+                if(has_candidates(x_j)){
+                    //Next candidate of x_j after the semi-join reduction
+                    c = semi_join_type::next(m_candidates[x_j], c);
+                    if(c == 0) return 0;
+                }
                 c_min = UINT64_MAX; c_max = 0;
             }
         }
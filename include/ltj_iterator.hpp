@@ -20,6 +20,10 @@
 #ifndef RING_LTJ_ITERATOR_HPP
 #define RING_LTJ_ITERATOR_HPP
 
+#include <array>
+#include <vector>
+#include <interval_cache.hpp>
+
 #define VERBOSE 0
 
 namespace ring {
@@ -45,8 +49,9 @@ namespace ring {
         value_type m_cur_p;
         value_type m_cur_o;
         bool m_is_empty = false;
-        //TODO: ao mellor hai que meter o nivel para saber cando parar de facer down
-        //std::stack<state_type> m_states;
+        bool m_keep_intervals = false;
+        //Intervals before each down, restored by up (only if m_keep_intervals)
+        std::vector<std::array<bwt_interval, 3>> m_states;
 
 
         void copy(const ltj_iterator &o) {
@@ -59,6 +64,8 @@ namespace ring {
             m_cur_p = o.m_cur_p;
             m_cur_o = o.m_cur_o;
             m_is_empty = o.m_is_empty;
+            m_keep_intervals = o.m_keep_intervals;
+            m_states = o.m_states;
         }
 
         inline bool is_variable_subject(var_type var) {
@@ -73,23 +80,8 @@ namespace ring {
             return m_ptr_triple_pattern->term_o.is_variable && var == m_ptr_triple_pattern->term_o.value;
         }
 
-    public:
-        const bool &is_empty = m_is_empty;
-        const bwt_interval &i_s = m_i_s;
-        const bwt_interval &i_p = m_i_p;
-        const bwt_interval &i_o = m_i_o;
-        const value_type &cur_s = m_cur_s;
-        const value_type &cur_p = m_cur_p;
-        const value_type &cur_o = m_cur_o;
-
-        ltj_iterator() = default;
-
-        ltj_iterator(const triple_pattern *triple, ring_type *ring) {
-            m_ptr_triple_pattern = triple;
-            m_ptr_ring = ring;
-            m_cur_s = -1;
-            m_cur_p = -1;
-            m_cur_o = -1;
+        //! Initial intervals and values according to the constants of the triple
+        void init() {
             m_i_p = m_ptr_ring->open_POS();
             m_i_s = m_ptr_ring->open_SPO();
             m_i_o = m_ptr_ring->open_OSP();
@@ -244,6 +236,51 @@ namespace ring {
             }
         }
 
+    public:
+        const bool &is_empty = m_is_empty;
+        const bwt_interval &i_s = m_i_s;
+        const bwt_interval &i_p = m_i_p;
+        const bwt_interval &i_o = m_i_o;
+        const value_type &cur_s = m_cur_s;
+        const value_type &cur_p = m_cur_p;
+        const value_type &cur_o = m_cur_o;
+
+        //! After down(), util::get_size_interval gives the triples of the new prefix
+        static const bool exact_intervals = true;
+
+        ltj_iterator() = default;
+
+        /**
+         * @param triple    Triple pattern
+         * @param ring      Index
+         * @param cache     (Optional) Initial states already computed for the constants of other patterns
+         */
+        ltj_iterator(const triple_pattern *triple, ring_type *ring, interval_cache *cache = nullptr) {
+            m_ptr_triple_pattern = triple;
+            m_ptr_ring = ring;
+            m_cur_s = -1;
+            m_cur_p = -1;
+            m_cur_o = -1;
+            if (cache == nullptr || (triple->s_is_variable() && triple->p_is_variable() && triple->o_is_variable())) {
+                init();
+                return;
+            }
+            auto key = interval_cache::key(*triple);
+            const interval_cache::entry_type *entry = cache->find(key);
+            if (entry != nullptr) {
+                m_i_s = entry->i_s;
+                m_i_p = entry->i_p;
+                m_i_o = entry->i_o;
+                m_cur_s = entry->cur_s;
+                m_cur_p = entry->cur_p;
+                m_cur_o = entry->cur_o;
+                m_is_empty = entry->is_empty;
+                return;
+            }
+            init();
+            cache->insert(key, {m_i_s, m_i_p, m_i_o, m_cur_s, m_cur_p, m_cur_o, m_is_empty});
+        }
+
         //! Copy constructor
         ltj_iterator(const ltj_iterator &o) {
             copy(o);
@@ -274,6 +311,8 @@ namespace ring {
                 m_cur_p = o.m_cur_p;
                 m_cur_o = o.m_cur_o;
                 m_is_empty = o.m_is_empty;
+                m_keep_intervals = o.m_keep_intervals;
+                m_states = std::move(o.m_states);
             }
             return *this;
         }
@@ -289,9 +328,22 @@ namespace ring {
             std::swap(m_cur_p, o.m_cur_p);
             std::swap(m_cur_o, o.m_cur_o);
             std::swap(m_is_empty, o.m_is_empty);
+            std::swap(m_keep_intervals, o.m_keep_intervals);
+            std::swap(m_states, o.m_states);
+        }
+
+        /**
+         * @brief If keep is true, up() restores the intervals overwritten by the
+         * last down(). It is only needed when the variable after an up() can be
+         * other than the one of the down() (adaptive orders). Set it before the
+         * first down().
+         */
+        void keep_intervals(const bool keep) {
+            m_keep_intervals = keep;
         }
 
         void down(var_type var, size_type c) { //Go down in the trie
+            if (m_keep_intervals) m_states.push_back({m_i_s, m_i_p, m_i_o});
             if (is_variable_subject(var)) {
                 if (m_cur_o != -1 && m_cur_p != -1){
 #if VERBOSE
@@ -382,6 +434,12 @@ namespace ring {
 
 
         void up(var_type var) { //Go up in the trie
+            if (m_keep_intervals) { //The intervals of the previous level may have been overwritten
+                m_i_s = m_states.back()[0];
+                m_i_p = m_states.back()[1];
+                m_i_o = m_states.back()[2];
+                m_states.pop_back();
+            }
             if (is_variable_subject(var)) {
                 m_cur_s = -1;
 #if VERBOSE
@@ -0,0 +1,351 @@
+/*
+ * ltj_optional.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_LTJ_OPTIONAL_HPP
+#define RING_LTJ_OPTIONAL_HPP
+
+#include <ltj_algorithm.hpp>
+#include <interval_cache.hpp>
+#include <unordered_map>
+
+namespace ring {
+
+    /**
+     * @brief Left outer join of a BGP with one or more OPTIONAL BGPs,
+     * ((P OPTIONAL O_1) OPTIONAL O_2) ... Each result of P is extended with the
+     * results of O_1, solved by a nested ltj_algorithm where its variables
+     * already bound are replaced by their values; if there are none, the result
+     * is kept as it is. Then the same with O_2, and so on.
+     *
+     * The extensions are cached by the values of the variables of O_i bound
+     * before it, so repeated bindings run the nested join only once. The nested
+     * joins of an O_i have the same shape, so they reuse its plan.
+     */
+    template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t,
+             class gao_t = gao::gao_size<ring_t, var_t, cons_t>>
+    class ltj_optional {
+
+    public:
+        typedef uint64_t value_type;
+        typedef uint64_t size_type;
+        typedef var_t var_type;
+        typedef ring_t ring_type;
+        typedef ltj_algorithm<ring_t, var_t, cons_t, gao_t> ltj_type;
+        typedef typename ltj_type::plan_cache_type plan_cache_type;
+        typedef typename ltj_type::tuple_type tuple_type;
+        typedef std::vector<value_type> key_type; //Value of each variable of an O_i, 0 if unbound
+
+    private:
+        struct hash_key {
+            size_t operator()(const key_type &k) const {
+                uint64_t h = 0;
+                for (const auto v : k) {
+                    h = (h ^ (h >> 29) ^ v) * 0xBF58476D1CE4E5B9ULL;
+                }
+                return h ^ (h >> 32);
+            }
+        };
+
+        typedef std::unordered_map<key_type, std::vector<tuple_type>, hash_key> extensions_type;
+
+        struct part_type {
+            std::vector<var_type> vars; //Variables of O_i and of its filters
+            extensions_type extensions;
+        };
+
+        const std::vector<triple_pattern>* m_ptr_required;
+        const std::vector<std::vector<triple_pattern>>* m_ptr_optionals;
+        const std::vector<std::vector<filter_pattern>>* m_ptr_optional_filters = nullptr;
+        ring_type* m_ptr_ring;
+        bool m_adaptive = false;
+        const stats_catalog* m_ptr_stats = nullptr;
+        plan_cache_type m_plans; //Plans of the nested joins
+        interval_cache* m_ptr_intervals = nullptr;
+        ltj_type m_required;
+        std::vector<part_type> m_parts;
+        size_type m_max_extensions;
+        size_type m_hits = 0;
+        size_type m_misses = 0;
+
+        void copy(const ltj_optional &o) {
+            m_ptr_required = o.m_ptr_required;
+            m_ptr_optionals = o.m_ptr_optionals;
+            m_ptr_optional_filters = o.m_ptr_optional_filters;
+            m_ptr_ring = o.m_ptr_ring;
+            m_adaptive = o.m_adaptive;
+            m_ptr_stats = o.m_ptr_stats;
+            m_plans = o.m_plans;
+            m_ptr_intervals = o.m_ptr_intervals;
+            m_required = o.m_required;
+            m_parts = o.m_parts;
+            m_max_extensions = o.m_max_extensions;
+            m_hits = o.m_hits;
+            m_misses = o.m_misses;
+        }
+
+        static void add_var(const term_pattern &term, std::vector<var_type> &vars) {
+            if (term.is_variable && std::find(vars.begin(), vars.end(), (var_type) term.value) == vars.end()) {
+                vars.push_back((var_type) term.value);
+            }
+        }
+
+        //! Value of var in tuple, 0 if it is unbound
+        static value_type value_of(const tuple_type &tuple, const var_type var) {
+            for (const auto &e : tuple) {
+                if (e.first == var) return e.second;
+            }
+            return 0;
+        }
+
+        //! Solutions of O_i given the values of its bound variables; false if the token stopped the join
+        bool solve_part(const size_type i, const key_type &key, std::vector<tuple_type> &res, cancel_token &token) {
+            const part_type &part = m_parts[i];
+            std::vector<triple_pattern> patterns = m_ptr_optionals->at(i);
+            for (auto &triple : patterns) {
+                for (size_type k = 0; k < part.vars.size(); ++k) {
+                    if (key[k] != 0) triple = triple.bind(part.vars[k], key[k]);
+                }
+            }
+            std::vector<filter_pattern> filters;
+            if (m_ptr_optional_filters != nullptr) {
+                //The variables bound before O_i are constants in its filters
+                auto value = [&part, &key](const uint64_t var) {
+                    for (size_type k = 0; k < part.vars.size(); ++k) {
+                        if (part.vars[k] == var) return key[k];
+                    }
+                    return (value_type) 0;
+                };
+                for (auto f : m_ptr_optional_filters->at(i)) {
+                    value_type a = value(f.var), b = f.term.is_variable ? value(f.term.value) : f.term.value;
+                    if (a != 0 && (b != 0 || !f.term.is_variable)) { //Both are constants
+                        if (!filter_pattern::holds(f.op, a, b)) return true;
+                        continue;
+                    }
+                    if (a != 0) { //?other mirror(op) a
+                        f.var = f.term.value;
+                        f.op = filter_pattern::mirror(f.op);
+                        f.term.value = a;
+                        f.term.is_variable = false;
+                    } else if (f.term.is_variable && b != 0) {
+                        f.term.value = b;
+                        f.term.is_variable = false;
+                    }
+                    filters.push_back(f);
+                }
+            }
+            ltj_type ltj(&patterns, m_ptr_ring, m_adaptive, m_ptr_stats, &m_plans, m_ptr_intervals, &filters);
+            ltj.join(res, 0, token);
+            return !token.cancelled();
+        }
+
+        template<class report_t>
+        bool extend(const size_type i, tuple_type &tuple, report_t &report, cancel_token &token) {
+            if (i == m_parts.size()) return report(tuple);
+            part_type &part = m_parts[i];
+            key_type key(part.vars.size());
+            for (size_type k = 0; k < part.vars.size(); ++k) {
+                key[k] = value_of(tuple, part.vars[k]);
+            }
+            const std::vector<tuple_type>* ptr_ext;
+            std::vector<tuple_type> ext;
+            auto it = part.extensions.find(key);
+            if (it != part.extensions.end()) {
+                ++m_hits;
+                ptr_ext = &it->second;
+            } else {
+                ++m_misses;
+                if (!solve_part(i, key, ext, token)) return false;
+                if (part.extensions.size() >= m_max_extensions) part.extensions.clear();
+                ptr_ext = &(part.extensions[key] = std::move(ext));
+            }
+            if (ptr_ext->empty()) return extend(i + 1, tuple, report, token);
+            size_type n = tuple.size();
+            for (const auto &e : *ptr_ext) {
+                tuple.insert(tuple.end(), e.begin(), e.end());
+                bool ok = extend(i + 1, tuple, report, token);
+                tuple.resize(n);
+                if (!ok) return false;
+            }
+            return true;
+        }
+
+    public:
+
+        ltj_optional() = default;
+
+        /**
+         *
+         * @param required          Triple patterns of the required BGP
+         * @param optionals         Triple patterns of each OPTIONAL BGP, in order
+         * @param ring              Index
+         * @param adaptive          Adaptive GAO (see ltj_algorithm)
+         * @param stats             (Optional) Statistics of the ring, used by the GAO
+         * @param cache             (Optional) Plans of the previous queries, for the required BGP
+         * @param intervals         (Optional) Initial states of the iterators of previous queries
+         * @param filters           (Optional) FILTERs of the required BGP
+         * @param optional_filters  (Optional) FILTERs of each OPTIONAL BGP
+         * @param max_extensions    Bindings cached by each OPTIONAL; its cache is emptied when it is full
+         */
+        ltj_optional(const std::vector<triple_pattern>* required,
+                     const std::vector<std::vector<triple_pattern>>* optionals, ring_type* ring,
+                     const bool adaptive = false, const stats_catalog* stats = nullptr,
+                     plan_cache_type* cache = nullptr, interval_cache* intervals = nullptr,
+                     const std::vector<filter_pattern>* filters = nullptr,
+                     const std::vector<std::vector<filter_pattern>>* optional_filters = nullptr,
+                     const size_type max_extensions = 65536)
+                : m_required(required, ring, adaptive, stats, cache, intervals, filters) {
+            m_ptr_required = required;
+            m_ptr_optionals = optionals;
+            m_ptr_optional_filters = optional_filters;
+            m_ptr_ring = ring;
+            m_adaptive = adaptive;
+            m_ptr_stats = stats;
+            m_ptr_intervals = intervals;
+            m_max_extensions = max_extensions;
+            m_parts.resize(m_ptr_optionals->size());
+            for (size_type i = 0; i < m_parts.size(); ++i) {
+                for (const auto &triple : m_ptr_optionals->at(i)) {
+                    add_var(triple.term_s, m_parts[i].vars);
+                    add_var(triple.term_p, m_parts[i].vars);
+                    add_var(triple.term_o, m_parts[i].vars);
+                }
+                if (m_ptr_optional_filters == nullptr) continue;
+                for (const auto &f : m_ptr_optional_filters->at(i)) {
+                    add_var({f.var, true}, m_parts[i].vars);
+                    add_var(f.term, m_parts[i].vars);
+                }
+            }
+        }
+
+        //! Copy constructor
+        ltj_optional(const ltj_optional &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        ltj_optional(ltj_optional &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        ltj_optional &operator=(const ltj_optional &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        ltj_optional &operator=(ltj_optional &&o) {
+            if (this != &o) {
+                m_ptr_required = std::move(o.m_ptr_required);
+                m_ptr_optionals = std::move(o.m_ptr_optionals);
+                m_ptr_optional_filters = o.m_ptr_optional_filters;
+                m_ptr_ring = std::move(o.m_ptr_ring);
+                m_adaptive = o.m_adaptive;
+                m_ptr_stats = o.m_ptr_stats;
+                m_plans = std::move(o.m_plans);
+                m_ptr_intervals = o.m_ptr_intervals;
+                m_required = std::move(o.m_required);
+                m_parts = std::move(o.m_parts);
+                m_max_extensions = o.m_max_extensions;
+                m_hits = o.m_hits;
+                m_misses = o.m_misses;
+            }
+            return *this;
+        }
+
+        void swap(ltj_optional &o) {
+            std::swap(m_ptr_required, o.m_ptr_required);
+            std::swap(m_ptr_optionals, o.m_ptr_optionals);
+            std::swap(m_ptr_optional_filters, o.m_ptr_optional_filters);
+            std::swap(m_ptr_ring, o.m_ptr_ring);
+            std::swap(m_adaptive, o.m_adaptive);
+            std::swap(m_ptr_stats, o.m_ptr_stats);
+            std::swap(m_plans, o.m_plans);
+            std::swap(m_ptr_intervals, o.m_ptr_intervals);
+            std::swap(m_required, o.m_required);
+            std::swap(m_parts, o.m_parts);
+            std::swap(m_max_extensions, o.m_max_extensions);
+            std::swap(m_hits, o.m_hits);
+            std::swap(m_misses, o.m_misses);
+        }
+
+        /**
+         *
+         * @param res               Results
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         */
+        void join(std::vector<tuple_type> &res,
+                  const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            join(res, limit_results, token);
+        };
+
+        //! join stopped by a cancel_token
+        void join(std::vector<tuple_type> &res, const size_type limit_results, cancel_token &token){
+            auto report = [&res, limit_results](const tuple_type &t){
+                res.emplace_back(t);
+                return limit_results == 0 || res.size() < limit_results;
+            };
+            join_report(report, token);
+        };
+
+        //! Reports the results one by one; stops when report returns false
+        template<class report_t>
+        bool join_report(report_t &report, cancel_token &token){
+            auto extend_required = [this, &report, &token](const tuple_type &t){
+                tuple_type tuple = t;
+                return extend(0, tuple, report, token);
+            };
+            if (m_ptr_required->empty()) return extend_required(tuple_type());
+            return m_required.join_report(extend_required, token);
+        };
+
+        /**
+         * @brief First k results ordered by the value of var. The results without
+         * var go first in ascending order and last in descending order, as
+         * unbound values in SPARQL. The results stream into a heap of size k.
+         */
+        void join_top_k(std::vector<tuple_type> &res, const var_type var, const size_type k,
+                        const bool descending = false, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            util::top_k_heap<tuple_type, var_type> heap(var, k, descending);
+            auto report = [&heap](const tuple_type &t){
+                heap.push(t);
+                return true;
+            };
+            join_report(report, token);
+            heap.pop_all(res);
+        };
+
+        //! Bindings whose extensions were taken from the cache
+        inline size_type hits() const {
+            return m_hits;
+        }
+
+        //! Bindings that ran a nested join
+        inline size_type misses() const {
+            return m_misses;
+        }
+    };
+}
+
+#endif
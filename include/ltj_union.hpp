@@ -0,0 +1,175 @@
+/*
+ * ltj_union.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_LTJ_UNION_HPP
+#define RING_LTJ_UNION_HPP
+
+#include <ltj_algorithm.hpp>
+#include <interval_cache.hpp>
+
+namespace ring {
+
+    /**
+     * @brief UNION of BGPs: the results of each branch, one after the other
+     * (with duplicates, as in SPARQL). Each branch is solved by its own
+     * ltj_algorithm. The branches build their iterators with the same
+     * interval_cache, so the patterns repeated across branches, or with the
+     * same constants, descend the wavelet matrices only once.
+     * The tuples of a branch only bind the variables of that branch.
+     */
+    template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t,
+             class gao_t = gao::gao_size<ring_t, var_t, cons_t>>
+    class ltj_union {
+
+    public:
+        typedef uint64_t value_type;
+        typedef uint64_t size_type;
+        typedef var_t var_type;
+        typedef ring_t ring_type;
+        typedef ltj_algorithm<ring_t, var_t, cons_t, gao_t> ltj_type;
+        typedef typename ltj_type::plan_cache_type plan_cache_type;
+        typedef typename ltj_type::tuple_type tuple_type;
+
+    private:
+        const std::vector<std::vector<triple_pattern>>* m_ptr_branches;
+        std::vector<ltj_type> m_branches;
+        interval_cache m_intervals; //Used when no cache is given
+
+        void copy(const ltj_union &o) {
+            m_ptr_branches = o.m_ptr_branches;
+            m_branches = o.m_branches;
+            m_intervals = o.m_intervals;
+        }
+
+    public:
+
+        ltj_union() = default;
+
+        /**
+         *
+         * @param branches          Triple patterns of each branch
+         * @param ring              Index
+         * @param adaptive          Adaptive GAO in the branches (see ltj_algorithm)
+         * @param stats             (Optional) Statistics of the ring, used by the GAO
+         * @param cache             (Optional) Plans of the previous queries
+         * @param intervals         (Optional) Initial states of the iterators of previous queries
+         * @param filters           (Optional) FILTERs of each branch
+         */
+        ltj_union(const std::vector<std::vector<triple_pattern>>* branches, ring_type* ring,
+                  const bool adaptive = false, const stats_catalog* stats = nullptr,
+                  plan_cache_type* cache = nullptr, interval_cache* intervals = nullptr,
+                  const std::vector<std::vector<filter_pattern>>* filters = nullptr){
+            m_ptr_branches = branches;
+            if(intervals == nullptr) intervals = &m_intervals;
+            //The iterators of a branch point to its vector: no reallocations
+            m_branches.reserve(m_ptr_branches->size());
+            for(size_type i = 0; i < m_ptr_branches->size(); ++i){
+                m_branches.emplace_back(&m_ptr_branches->at(i), ring, adaptive, stats, cache, intervals,
+                                        filters == nullptr ? nullptr : &filters->at(i));
+            }
+        }
+
+        //! Copy constructor
+        ltj_union(const ltj_union &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        ltj_union(ltj_union &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        ltj_union &operator=(const ltj_union &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        ltj_union &operator=(ltj_union &&o) {
+            if (this != &o) {
+                m_ptr_branches = std::move(o.m_ptr_branches);
+                m_branches = std::move(o.m_branches);
+                m_intervals = std::move(o.m_intervals);
+            }
+            return *this;
+        }
+
+        void swap(ltj_union &o) {
+            std::swap(m_ptr_branches, o.m_ptr_branches);
+            std::swap(m_branches, o.m_branches);
+            std::swap(m_intervals, o.m_intervals);
+        }
+
+        /**
+         *
+         * @param res               Results
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         */
+        void join(std::vector<tuple_type> &res,
+                  const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            join(res, limit_results, token);
+        };
+
+        //! join stopped by a cancel_token
+        void join(std::vector<tuple_type> &res, const size_type limit_results, cancel_token &token){
+            auto report = [&res, limit_results](const tuple_type &t){
+                res.emplace_back(t);
+                return limit_results == 0 || res.size() < limit_results;
+            };
+            join_report(report, token);
+        };
+
+        //! Reports the results of each branch; stops when report returns false
+        template<class report_t>
+        bool join_report(report_t &report, cancel_token &token){
+            for(auto &branch : m_branches){
+                if(!branch.join_report(report, token)) return false;
+            }
+            return true;
+        };
+
+        /**
+         * @brief First k results ordered by the value of var. The results without
+         * var go first in ascending order and last in descending order, as
+         * unbound values in SPARQL. The results stream into a heap of size k.
+         */
+        void join_top_k(std::vector<tuple_type> &res, const var_type var, const size_type k,
+                        const bool descending = false, const size_type timeout_seconds = 0){
+            cancel_token token(timeout_seconds * 1000);
+            util::top_k_heap<tuple_type, var_type> heap(var, k, descending);
+            auto report = [&heap](const tuple_type &t){
+                heap.push(t);
+                return true;
+            };
+            join_report(report, token);
+            heap.pop_all(res);
+        };
+
+        inline size_type n_branches() const {
+            return m_branches.size();
+        }
+    };
+}
+
+#endif
@@ -294,6 +294,123 @@ namespace ring
       throw std::invalid_argument(s + " not in Plain Front Coding");
     }
 
+    /**
+     * @brief Searches the strings sorted[b, e), which must be sorted, with a
+     * single scan of the PFC that decodes each of its strings once. Strings not
+     * found get the ID 0
+     *
+     * @param sorted The strings being searched
+     * @param b First string searched
+     * @param e End of the strings searched
+     * @param ids Vector where the ID of sorted[i] is stored in ids[i]
+     */
+    void locate_batch(const std::vector<std::string> &sorted, uint64_t b, uint64_t e, std::vector<uint64_t> &ids)
+    {
+      uint64_t index = 0, i = b;
+      std::string prev, curr;
+      uint64_t curr_id;
+
+      if (current_size > 0)
+      {
+        curr_id = decode_number(index);
+        read_string(index, curr);
+        while (i < e)
+        {
+          while (i < e && sorted[i] < curr)
+            ids[i++] = 0;
+          if (i < e && sorted[i] == curr)
+            ids[i++] = curr_id;
+          if (index >= text_string.size())
+            break;
+          prev = curr;
+          curr_id = decode_number(index);
+          uint64_t lcp = decode_number(index);
+          read_string(index, curr, prev, lcp);
+        }
+      }
+      for (; i < e; i++)
+        ids[i] = 0;
+    }
+
+    /**
+     * @brief Gets the IDs of the neighbours of a string that is not stored
+     *
+     * @param s The string
+     * @param prev ID of the largest string smaller than s, 0 if there is none
+     * @param next ID of the smallest string greater than s, 0 if there is none
+     */
+    void neighbours(const std::string &s, uint64_t &prev, uint64_t &next)
+    {
+      uint64_t index = 0;
+      std::string prev_str, curr;
+      prev = next = 0;
+
+      if (current_size == 0)
+        return;
+      uint64_t curr_id = decode_number(index);
+      read_string(index, curr);
+      while (curr < s)
+      {
+        prev = curr_id;
+        if (index >= text_string.size())
+          return;
+        prev_str = curr;
+        curr_id = decode_number(index);
+        uint64_t lcp = decode_number(index);
+        read_string(index, curr, prev_str, lcp);
+      }
+      next = curr_id;
+    }
+
+    /**
+     * @brief Deletes the strings with the given IDs, rewriting the PFC once
+     *
+     * @param ids The IDs of the strings being deleted, sorted
+     */
+    void elim_batch(const std::vector<uint64_t> &ids)
+    {
+      uint64_t index = 0, removed = 0;
+      std::string prev, curr, kept, res;
+      bool first = true, first_kept = true;
+
+      while (index < text_string.size())
+      {
+        uint64_t curr_id = decode_number(index);
+        if (first)
+        {
+          read_string(index, curr);
+        }
+        else
+        {
+          uint64_t lcp = decode_number(index);
+          read_string(index, curr, prev, lcp);
+        }
+        prev = curr;
+        first = false;
+
+        if (std::binary_search(ids.begin(), ids.end(), curr_id))
+        {
+          removed++;
+          continue;
+        }
+        res += encode_number(curr_id);
+        if (!first_kept)
+        {
+          uint64_t lcp = longest_common_prefix(kept, curr, std::min(kept.size(), curr.size()));
+          res += encode_number(lcp) + curr.substr(lcp);
+        }
+        else
+        {
+          res += curr;
+        }
+        res += '\0';
+        kept = curr;
+        first_kept = false;
+      }
+      text_string.swap(res);
+      current_size -= removed;
+    }
+
     /**
      * @brief Search a string with the given ID
      * If its not found it throws an invalid_argument error
@@ -572,6 +689,33 @@ namespace ring
       return text_string;
     }
 
+    /**
+     * @brief Replaces every ID by map[ID]. The strings and their order are kept
+     *
+     * @param map New ID of every old ID
+     */
+    void remap_ids(const std::vector<uint64_t> &map)
+    {
+      if (current_size == 0)
+        return;
+      uint64_t index = 0, start, end;
+      std::string res = encode_number(map[decode_number(index)]);
+      end = text_string.find_first_of('\0', index) + 1;
+      res.append(text_string, index, end - index);
+      index = end;
+
+      while (index < text_string.size())
+      {
+        res += encode_number(map[decode_number(index)]);
+        start = index;
+        decode_number(index); // LCP
+        end = text_string.find_first_of('\0', index) + 1;
+        res.append(text_string, start, end - start);
+        index = end;
+      }
+      text_string.swap(res);
+    }
+
   private:
     uint64_t current_size;   // Amount of words stored in the PFC
     std::string text_string; // The actual bytes of the PFC
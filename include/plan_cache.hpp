@@ -0,0 +1,240 @@
+/*
+ * plan_cache.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_PLAN_CACHE_HPP
+#define RING_PLAN_CACHE_HPP
+
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include <triple_pattern.hpp>
+
+namespace ring {
+
+    /**
+     * @brief Plans of the queries already solved, keyed by the shape of their BGP:
+     * the variables renamed by order of appearance and the constants abstracted.
+     * A plan keeps what only depends on the shape: the patterns where each
+     * variable occurs, the variables related by a pattern and the GAO of the
+     * last query planned, with the interval sizes of its variables. The queries
+     * of a known shape wire their iterators and get their GAO from the plan
+     * (see from_plan in gao.hpp) instead of running the planner.
+     * The key of a shape is built in a buffer of the cache, so a lookup does
+     * not allocate.
+     */
+    template<class var_t = uint8_t>
+    class plan_cache {
+
+    public:
+        typedef uint64_t size_type;
+        typedef var_t var_type;
+
+        struct plan_type {
+            std::vector<var_type> gao;                   // renamed variables
+            std::vector<size_type> wiring_begin;         // renamed variable -> its first entry in wiring
+            std::vector<size_type> wiring;               // patterns of each renamed variable, one after the other
+            std::vector<std::vector<size_type>> related; // renamed variable -> variables in its patterns
+            std::vector<size_type> sizes;                // renamed variable -> its smallest interval when planned
+
+            inline size_type n_vars() const {
+                return sizes.size();
+            }
+
+            //! Number of patterns of the renamed variable v
+            inline size_type n_patterns(const size_type v) const {
+                return wiring_begin[v + 1] - wiring_begin[v];
+            }
+        };
+
+    private:
+        std::unordered_map<std::string, plan_type> m_plans;
+        size_type m_max_plans;
+        size_type m_hits = 0;
+        size_type m_misses = 0;
+        std::string m_key; // key of the last shape searched
+
+        void copy(const plan_cache &o) {
+            m_plans = o.m_plans;
+            m_max_plans = o.m_max_plans;
+            m_hits = o.m_hits;
+            m_misses = o.m_misses;
+        }
+
+        static void add_term(const term_pattern &term, std::string &key, std::vector<var_type> &vars) {
+            if (!term.is_variable) {
+                key.push_back(0);
+                return;
+            }
+            size_type v = rename(vars, term.value);
+            if (v == vars.size()) vars.push_back(term.value);
+            key.push_back(1);
+            key.push_back((char) (v & 0xFF));
+            key.push_back((char) (v >> 8));
+        }
+
+        //! Renamed variable of var, or vars.size() if it is not in vars
+        static size_type rename(const std::vector<var_type> &vars, const uint64_t var) {
+            size_type v = 0;
+            while (v < vars.size() && vars[v] != var) ++v;
+            return v;
+        }
+
+    public:
+
+        //! Up to max_plans plans are kept; the cache is emptied when it is full
+        plan_cache(const size_type max_plans = 1024) : m_max_plans(max_plans) {}
+
+        //! Copy constructor
+        plan_cache(const plan_cache &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        plan_cache(plan_cache &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        plan_cache &operator=(const plan_cache &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        plan_cache &operator=(plan_cache &&o) {
+            if (this != &o) {
+                m_plans = std::move(o.m_plans);
+                m_max_plans = o.m_max_plans;
+                m_hits = o.m_hits;
+                m_misses = o.m_misses;
+            }
+            return *this;
+        }
+
+        void swap(plan_cache &o) {
+            std::swap(m_plans, o.m_plans);
+            std::swap(m_max_plans, o.m_max_plans);
+            std::swap(m_hits, o.m_hits);
+            std::swap(m_misses, o.m_misses);
+        }
+
+        /**
+         * @brief Shape of a BGP
+         *
+         * @param triple_patterns   Triple patterns of the query
+         * @param vars              Returns the variable of the query behind each renamed variable
+         * @param key               Returns the key of the shape
+         */
+        static void shape(const std::vector<triple_pattern> &triple_patterns, std::vector<var_type> &vars,
+                          std::string &key) {
+            key.clear();
+            vars.clear();
+            for (const auto &triple : triple_patterns) {
+                add_term(triple.term_s, key, vars);
+                add_term(triple.term_p, key, vars);
+                add_term(triple.term_o, key, vars);
+            }
+        }
+
+        /**
+         * @brief Plan of the shape of a BGP
+         *
+         * @param triple_patterns   Triple patterns of the query
+         * @param vars              Returns the variable of the query behind each renamed variable
+         * @return                  The plan, or nullptr if it is not cached
+         */
+        const plan_type *find(const std::vector<triple_pattern> &triple_patterns, std::vector<var_type> &vars) {
+            shape(triple_patterns, vars, m_key);
+            auto it = m_plans.find(m_key);
+            if (it == m_plans.end()) {
+                ++m_misses;
+                return nullptr;
+            }
+            ++m_hits;
+            return &it->second;
+        }
+
+        /**
+         * @brief Caches the plan of the shape of the last call to find, replacing
+         * the plan of that shape if there was one
+         *
+         * @param vars              Variables returned by find
+         * @param triple_patterns   Triple patterns of the query
+         * @param gao               GAO of the query
+         * @param sizes             Smallest interval of each renamed variable
+         */
+        void insert(const std::vector<var_type> &vars, const std::vector<triple_pattern> &triple_patterns,
+                    const std::vector<var_type> &gao, const std::vector<size_type> &sizes) {
+            if (m_plans.size() >= m_max_plans) m_plans.clear();
+            plan_type plan;
+            plan.gao.reserve(gao.size());
+            for (const auto var : gao) {
+                plan.gao.push_back(rename(vars, var));
+            }
+            plan.sizes = sizes;
+            //Same order of iterators as ltj_algorithm
+            std::vector<std::vector<size_type>> wiring(vars.size());
+            plan.related.resize(vars.size());
+            for (size_type i = 0; i < triple_patterns.size(); ++i) {
+                const triple_pattern &triple = triple_patterns[i];
+                std::vector<size_type> in_triple;
+                if (triple.o_is_variable()) in_triple.push_back(rename(vars, triple.term_o.value));
+                if (triple.p_is_variable()) in_triple.push_back(rename(vars, triple.term_p.value));
+                if (triple.s_is_variable()) in_triple.push_back(rename(vars, triple.term_s.value));
+                for (const auto v : in_triple) {
+                    wiring[v].push_back(i);
+                    for (const auto r : in_triple) {
+                        if (r != v) plan.related[v].push_back(r);
+                    }
+                }
+            }
+            plan.wiring_begin.push_back(0);
+            for (const auto &w : wiring) {
+                plan.wiring.insert(plan.wiring.end(), w.begin(), w.end());
+                plan.wiring_begin.push_back(plan.wiring.size());
+            }
+            for (auto &rel : plan.related) {
+                std::sort(rel.begin(), rel.end());
+                rel.erase(std::unique(rel.begin(), rel.end()), rel.end());
+            }
+            m_plans[m_key] = std::move(plan);
+        }
+
+        void clear() {
+            m_plans.clear();
+        }
+
+        inline size_type size() const {
+            return m_plans.size();
+        }
+
+        inline size_type hits() const {
+            return m_hits;
+        }
+
+        inline size_type misses() const {
+            return m_misses;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,485 @@
+/*
+ * rank_select_simd.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_RANK_SELECT_SIMD_HPP
+#define RING_RANK_SELECT_SIMD_HPP
+
+#include "configuration.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RING_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define RING_SIMD_X86 0
+#endif
+
+namespace ring {
+
+    namespace simd {
+
+        typedef uint64_t (*popcount_words_type)(const uint64_t *words, uint64_t n_words);
+        typedef uint64_t (*select_word_type)(uint64_t word, uint64_t k);
+
+        // Kernels chosen once at startup according to the features of the CPU
+        struct kernels_type {
+            popcount_words_type popcount_words;
+            select_word_type select_word;
+            const char *name;
+        };
+
+        inline uint64_t popcount_words_scalar(const uint64_t *words, uint64_t n_words) {
+            uint64_t res = 0;
+            for (uint64_t i = 0; i < n_words; ++i) {
+                res += sdsl::bits::cnt(words[i]);
+            }
+            return res;
+        }
+
+        // k-th one (k >= 1) of the word
+        inline uint64_t select_word_scalar(uint64_t word, uint64_t k) {
+            return sdsl::bits::sel(word, (uint32_t) k);
+        }
+
+#if RING_SIMD_X86
+        // Nibble lookup popcount (Mula et al.) over 256-bit lanes
+        __attribute__((target("avx2,popcnt")))
+        inline uint64_t popcount_words_avx2(const uint64_t *words, uint64_t n_words) {
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_mask = _mm256_set1_epi8(0x0f);
+            __m256i acc = _mm256_setzero_si256();
+            uint64_t i = 0;
+            for (; i + 4 <= n_words; i += 4) {
+                __m256i v = _mm256_loadu_si256((const __m256i *) (words + i));
+                __m256i lo = _mm256_and_si256(v, low_mask);
+                __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+                __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+            }
+            uint64_t res = (uint64_t) _mm256_extract_epi64(acc, 0) + (uint64_t) _mm256_extract_epi64(acc, 1)
+                           + (uint64_t) _mm256_extract_epi64(acc, 2) + (uint64_t) _mm256_extract_epi64(acc, 3);
+            for (; i < n_words; ++i) {
+                res += (uint64_t) _mm_popcnt_u64(words[i]);
+            }
+            return res;
+        }
+
+        // Masked loads never touch the words after n_words
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        inline uint64_t popcount_words_avx512(const uint64_t *words, uint64_t n_words) {
+            __m512i acc = _mm512_setzero_si512();
+            uint64_t i = 0;
+            for (; i + 8 <= n_words; i += 8) {
+                acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *) (words + i))));
+            }
+            if (i < n_words) {
+                __mmask8 mask = (__mmask8) ((1u << (n_words - i)) - 1);
+                acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(mask, words + i)));
+            }
+            return (uint64_t) _mm512_reduce_add_epi64(acc);
+        }
+
+        __attribute__((target("bmi,bmi2")))
+        inline uint64_t select_word_bmi2(uint64_t word, uint64_t k) {
+            return _tzcnt_u64(_pdep_u64(1ULL << (k - 1), word));
+        }
+#endif
+
+        inline kernels_type detect_kernels() {
+            kernels_type k = {popcount_words_scalar, select_word_scalar, "scalar"};
+#if RING_SIMD_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512vpopcntdq")) {
+                k.popcount_words = popcount_words_avx512;
+                k.name = "avx512";
+            } else if (__builtin_cpu_supports("avx2")) {
+                k.popcount_words = popcount_words_avx2;
+                k.name = "avx2";
+            }
+            if (__builtin_cpu_supports("bmi2")) {
+                k.select_word = select_word_bmi2;
+            }
+#endif
+            return k;
+        }
+
+        inline const kernels_type &kernels() {
+            static const kernels_type k = detect_kernels();
+            return k;
+        }
+    }
+
+    template<uint8_t t_b>
+    class rank_support_simd;
+
+    template<uint8_t t_b>
+    class select_support_simd;
+
+    /**
+     * @brief Bitvector with the counters of its rank and select supports, in a
+     * poppy-like interleaved layout.
+     * Every block of 2048 bits has a 64-bit entry with its count relative to
+     * an absolute counter stored every 2^32 bits (low 32 bits) and the counts of
+     * its first three 512-bit sub-blocks (10 bits each).
+     * The sub-blocks are counted with the SIMD kernel of the CPU when the
+     * counters are built. The counters are stored once, here, and shared by
+     * rank_support_simd and both select_support_simd.
+     */
+    class bit_vector_simd {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef rank_support_simd<1> rank_1_type;
+        typedef rank_support_simd<0> rank_0_type;
+        typedef select_support_simd<1> select_1_type;
+        typedef select_support_simd<0> select_0_type;
+
+    private:
+        bit_vector m_bits;
+        int_vector<64> m_l0;  // ones before every 2^32 bits
+        int_vector<64> m_l12; // relative count + sub-block counts of every block of 2048 bits
+
+        template<uint8_t>
+        friend class rank_support_simd;
+
+        template<uint8_t>
+        friend class select_support_simd;
+
+        void build() {
+            uint64_t n = m_bits.size();
+            uint64_t n_words = (n + 63) >> 6;
+            uint64_t n_blocks = (n >> 11) + 1;
+            const uint64_t *data = m_bits.data();
+            const simd::kernels_type &kernels = simd::kernels();
+            m_l0 = int_vector<64>((n >> 32) + 1, 0);
+            m_l12 = int_vector<64>(n_blocks, 0);
+            uint64_t total = 0;
+            for (uint64_t b = 0; b < n_blocks; ++b) {
+                if (((b << 11) & 0xffffffffULL) == 0) {
+                    m_l0[b >> 21] = total;
+                }
+                uint64_t entry = total - m_l0[b >> 21];
+                for (uint64_t s = 0; s < 4; ++s) {
+                    uint64_t cnt = 0;
+                    uint64_t first = (b << 5) + (s << 3);
+                    uint64_t last = std::min(first + 8, n_words);
+                    if (first < last) {
+                        cnt = kernels.popcount_words(data + first, last - first);
+                        if (last == n_words && (n & 63)) { //Bits after the end of the last word
+                            cnt -= sdsl::bits::cnt(data[last - 1] & ~((1ULL << (n & 63)) - 1));
+                        }
+                    }
+                    if (s < 3) {
+                        entry |= cnt << (32 + 10 * s);
+                    }
+                    total += cnt;
+                }
+                m_l12[b] = entry;
+            }
+        }
+
+        //! Number of ones before block b
+        inline uint64_t ones_before_block(uint64_t b) const {
+            return m_l0[b >> 21] + (m_l12[b] & 0xffffffffULL);
+        }
+
+        inline uint64_t rank1(uint64_t i) const {
+            uint64_t e = m_l12[i >> 11];
+            uint64_t res = m_l0[i >> 32] + (e & 0xffffffffULL);
+            uint64_t sub = (i >> 9) & 3;
+            for (uint64_t s = 0; s < sub; ++s) {
+                res += (e >> (32 + 10 * s)) & 0x3ff;
+            }
+            const uint64_t *words = m_bits.data() + ((i >> 9) << 3);
+            uint64_t w = (i >> 6) & 7;
+            //At most 7 words: popcnt of each word is cheaper than a call to the SIMD kernel
+            for (uint64_t k = 0; k < w; ++k) {
+                res += sdsl::bits::cnt(words[k]);
+            }
+            if (i & 63) {
+                res += sdsl::bits::cnt(words[w] & ((1ULL << (i & 63)) - 1));
+            }
+            return res;
+        }
+
+        void copy(const bit_vector_simd &o) {
+            m_bits = o.m_bits;
+            m_l0 = o.m_l0;
+            m_l12 = o.m_l12;
+        }
+
+    public:
+        bit_vector_simd() = default;
+
+        bit_vector_simd(const bit_vector &bv) : m_bits(bv) {
+            build();
+        }
+
+        bit_vector_simd(bit_vector &&bv) : m_bits(std::move(bv)) {
+            build();
+        }
+
+        //! Copy constructor
+        bit_vector_simd(const bit_vector_simd &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        bit_vector_simd(bit_vector_simd &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        bit_vector_simd &operator=(const bit_vector_simd &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        bit_vector_simd &operator=(bit_vector_simd &&o) {
+            if (this != &o) {
+                m_bits = std::move(o.m_bits);
+                m_l0 = std::move(o.m_l0);
+                m_l12 = std::move(o.m_l12);
+            }
+            return *this;
+        }
+
+        void swap(bit_vector_simd &o) {
+            m_bits.swap(o.m_bits);
+            m_l0.swap(o.m_l0);
+            m_l12.swap(o.m_l12);
+        }
+
+        inline size_type size() const {
+            return m_bits.size();
+        }
+
+        inline value_type operator[](size_type i) const {
+            return m_bits[i];
+        }
+
+        //! Integer of len bits (len <= 64) starting at position idx
+        uint64_t get_int(size_type idx, uint8_t len = 64) const {
+            return m_bits.get_int(idx, len);
+        }
+
+        inline const uint64_t *data() const {
+            return m_bits.data();
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "bit_vector_simd");
+            size_type written_bytes = 0;
+            written_bytes += m_bits.serialize(out, child, "bits");
+            written_bytes += m_l0.serialize(out, child, "l0");
+            written_bytes += m_l12.serialize(out, child, "l12");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            m_bits.load(in);
+            m_l0.load(in);
+            m_l12.load(in);
+        }
+    };
+
+    /**
+     * @brief Rank support of bit_vector_simd. The counters live inside the
+     * bitvector, so this class only keeps a pointer to it; a rank counts the
+     * at most 7 words left with popcnt.
+     *
+     * @tparam t_b The bit pattern being ranked (0 or 1)
+     */
+    template<uint8_t t_b = 1>
+    class rank_support_simd {
+
+        static_assert(t_b == 0 || t_b == 1, "rank_support_simd: bit pattern must be 0 or 1");
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_simd bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t) 1 };
+
+    private:
+        const bit_vector_type *m_v = nullptr;
+
+    public:
+        explicit rank_support_simd(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        //! Number of t_b bits in [0, i)
+        inline size_type rank(size_type i) const {
+            return t_b ? m_v->rank1(i) : i - m_v->rank1(i);
+        }
+
+        inline size_type operator()(size_type i) const {
+            return rank(i);
+        }
+
+        size_type size() const {
+            return m_v == nullptr ? 0 : m_v->size();
+        }
+
+        void set_vector(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(rank_support_simd &) {}
+
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            sdsl::structure_tree::add_size(child, 0);
+            return 0;
+        }
+
+        void load(std::istream &, const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+    };
+
+    /**
+     * @brief Select support on top of the counters of bit_vector_simd.
+     * It samples the block of every 8192-th t_b bit, binary searches the blocks
+     * between two samples and solves the last word with PDEP when available.
+     *
+     * @tparam t_b The bit pattern being selected (0 or 1)
+     */
+    template<uint8_t t_b = 1>
+    class select_support_simd {
+
+        static_assert(t_b == 0 || t_b == 1, "select_support_simd: bit pattern must be 0 or 1");
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_simd bit_vector_type;
+        enum { bit_pat = t_b };
+        enum { bit_pat_len = (uint8_t) 1 };
+
+    private:
+        static const uint64_t sample_rate = 8192;
+
+        const bit_vector_type *m_v = nullptr;
+        simd::select_word_type m_select_word = simd::kernels().select_word; //Resolved once per structure
+        int_vector<64> m_samples; // block of every sample_rate-th t_b bit
+
+        inline uint64_t count_before_block(uint64_t b) const {
+            uint64_t ones = m_v->ones_before_block(b);
+            return t_b ? ones : (b << 11) - ones;
+        }
+
+        inline uint64_t count_in_sub_block(uint64_t e, uint64_t s) const {
+            uint64_t ones = (e >> (32 + 10 * s)) & 0x3ff;
+            return t_b ? ones : 512 - ones;
+        }
+
+        inline uint64_t pattern_word(uint64_t word) const {
+            return t_b ? word : ~word;
+        }
+
+        void build() {
+            uint64_t n_blocks = m_v->m_l12.size();
+            uint64_t total = t_b ? m_v->rank1(m_v->size()) : m_v->size() - m_v->rank1(m_v->size());
+            m_samples = int_vector<64>(total / sample_rate + 1, 0);
+            uint64_t b = 0;
+            for (uint64_t k = 0; k < m_samples.size(); ++k) {
+                // Last block with less than k*sample_rate+1 pattern bits before it
+                while (b + 1 < n_blocks && count_before_block(b + 1) <= k * sample_rate) {
+                    ++b;
+                }
+                m_samples[k] = b;
+            }
+        }
+
+    public:
+        explicit select_support_simd(const bit_vector_type *v = nullptr) {
+            m_v = v;
+            if (m_v != nullptr) {
+                build();
+            }
+        }
+
+        //! Position of the i-th (i >= 1) t_b bit
+        inline size_type select(size_type i) const {
+            uint64_t k = (i - 1) / sample_rate;
+            uint64_t lo = m_samples[k];
+            uint64_t hi = (k + 1 < m_samples.size()) ? m_samples[k + 1] : m_v->m_l12.size() - 1;
+            while (lo < hi) {
+                uint64_t mid = (lo + hi + 1) >> 1;
+                if (count_before_block(mid) < i) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            uint64_t rem = i - count_before_block(lo);
+            uint64_t e = m_v->m_l12[lo];
+            uint64_t s = 0;
+            for (; s < 3; ++s) {
+                uint64_t c = count_in_sub_block(e, s);
+                if (rem <= c) break;
+                rem -= c;
+            }
+            const uint64_t *words = m_v->data() + (lo << 5) + (s << 3);
+            uint64_t w = 0;
+            for (;; ++w) {
+                uint64_t c = sdsl::bits::cnt(pattern_word(words[w]));
+                if (rem <= c) break;
+                rem -= c;
+            }
+            return (lo << 11) + (s << 9) + (w << 6) + m_select_word(pattern_word(words[w]), rem);
+        }
+
+        inline size_type operator()(size_type i) const {
+            return select(i);
+        }
+
+        void set_vector(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(select_support_simd &o) {
+            m_samples.swap(o.m_samples);
+            std::swap(m_select_word, o.m_select_word);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = m_samples.serialize(out, child, "samples");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in, const bit_vector_type *v = nullptr) {
+            m_v = v;
+            m_select_word = simd::kernels().select_word;
+            m_samples.load(in);
+        }
+    };
+}
+
+#endif
@@ -42,6 +42,8 @@ namespace ring
         typedef std::tuple<uint32_t, uint32_t, uint32_t> spo_triple_type;
 
     private:
+        template <class, class> friend class ring;
+
         bwt_so_type m_bwt_s; // POS
         bwt_p_type m_bwt_p;  // OSP
         bwt_so_type m_bwt_o; // SPO
@@ -204,6 +206,29 @@ namespace ring
             // cout << "-- Index constructed successfully" << endl; fflush(stdout);
         };
 
+        /**
+         * @brief Builds the ring from one with other BWT types (e.g. a static ring into a
+         * dynamic one). L and C are taken from the BWTs of o, so the triples are neither
+         * extracted nor sorted again. The target BWTs need a (L, C, sigma) constructor.
+         * Dynamic BWTs are still built one entry at a time (see bwt_dyn): converting into
+         * a dynamic ring only saves extracting and sorting the triples.
+         */
+        template <class bwt_so2_t, class bwt_p2_t>
+        explicit ring(const ring<bwt_so2_t, bwt_p2_t> &o)
+        {
+            m_max_s = o.m_max_s;
+            m_max_p = o.m_max_p;
+            m_max_o = o.m_max_o;
+            m_n_triples = o.m_n_triples;
+            vector<uint64_t> L, C;
+            o.m_bwt_o.decode(L, C);
+            m_bwt_o = bwt_so_type(L, C, m_max_o);
+            o.m_bwt_p.decode(L, C);
+            m_bwt_p = bwt_p_type(L, C, m_max_p);
+            o.m_bwt_s.decode(L, C);
+            m_bwt_s = bwt_so_type(L, C, m_max_s);
+        }
+
         //! Copy constructor
         ring(const ring &o)
         {
@@ -808,7 +833,9 @@ namespace ring
 
         uint64_t next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value);
 
-        void insert(spo_triple triple);
+        bool contains(spo_triple triple) const;
+
+        bool insert(spo_triple triple);
 
         spo_valid_triple remove_edge_and_check(spo_triple triple);
 
@@ -820,6 +847,38 @@ namespace ring
 
         uint64_t bit_size();
 
+        inline size_type n_triples() const
+        {
+            return m_n_triples;
+        }
+
+        //! Size of the subject/object alphabet
+        inline size_type max_so() const
+        {
+            return m_max_o;
+        }
+
+        //! Size of the predicate alphabet
+        inline size_type max_p() const
+        {
+            return m_max_p;
+        }
+
+        void get_triples(vector<spo_triple_type> &D);
+
+        void remap_ids(vector<uint64_t> &so_map, vector<uint64_t> &p_map);
+
+        //! Rebuilds the triples into a ring_out_t, e.g. to compact a dynamic ring into a static one
+        template <class ring_out_t>
+        ring_out_t compact()
+        {
+            vector<spo_triple_type> D;
+            get_triples(D);
+            if (D.empty())
+                return ring_out_t();
+            return ring_out_t(D);
+        }
+
         uint64_t min_P_in_OS(bwt_interval &I)
         {
             return I.begin(m_bwt_p);
@@ -1005,21 +1064,46 @@ namespace ring
         return s;
     }
 
+    /**
+     * @brief Checks if a triple is stored, with a backward search of its three
+     *        components (as init_SPO). Costs as much as a query.
+     *
+     * @param triple The triple being searched
+     * @return true if the triple is in the ring
+     */
+    template <class bwt_so_t, class bwt_p_t>
+    bool ring<bwt_so_t, bwt_p_t>::contains(spo_triple triple) const
+    {
+        uint64_t s = get<0>(triple);
+        uint64_t p = get<1>(triple);
+        uint64_t o = get<2>(triple);
+
+        if (s == 0 || p == 0 || o == 0 || s > m_max_s || p > m_max_p || o > m_max_o)
+            return false;
+        auto I = init_SPO(s, p, o);
+        return I.first <= I.second;
+    }
+
      /**
      * @brief Insert a triple in the ring. Keeps the sorting
      *        and updates the bitvectors in the wavelet trees
-     * If the triple exists then it doesn't insert it
+     * If the triple exists then it doesn't insert it, and returns before
+     * touching the alphabets or the wavelet trees
      *
      * @tparam
      * @param triple The triple being inserted
+     * @return true if the triple was inserted
      */
     template <class bwt_so_t, class bwt_p_t>
-    void ring<bwt_so_t, bwt_p_t>::insert(spo_triple triple)
+    bool ring<bwt_so_t, bwt_p_t>::insert(spo_triple triple)
     {
         uint64_t s = get<0>(triple);
         uint64_t p = get<1>(triple);
         uint64_t o = get<2>(triple);
 
+        if (contains(triple))
+            return false;
+
         uint64_t low = 0, high = 0;
 
         // Update the alphabet size if the symbols are new
@@ -1029,12 +1113,14 @@ namespace ring
             m_bwt_p.push_back_C(1);
             m_bwt_o.increment_alphabet();
             m_bwt_s.increment_alphabet();
+            m_max_s = m_max_o = m_bwt_s.alphabet_size();
         }
 
         if (p > m_bwt_p.alphabet_size())
         {
             m_bwt_s.push_back_C(1);
             m_bwt_p.increment_alphabet();
+            m_max_p = m_bwt_p.alphabet_size();
         }
 
         if (o > m_bwt_o.alphabet_size())
@@ -1043,6 +1129,7 @@ namespace ring
             m_bwt_o.push_back_C(1);
             m_bwt_o.increment_alphabet();
             m_bwt_s.increment_alphabet();
+            m_max_s = m_max_o = m_bwt_s.alphabet_size();
         }
 
         // Insert in the wavelet trees
@@ -1062,8 +1149,9 @@ namespace ring
             insert_index = m_bwt_p.get_C(o) + m_bwt_o.ranky(insert_index, o);
             m_bwt_p.insert_WT(insert_index, p);
             m_bwt_s.insert_C(m_bwt_s.select_C(p + 1), 0);
-            
-            return;
+
+            ++m_n_triples;
+            return true;
         }
 
         low = m_bwt_o.get_C(s) + m_bwt_s.ranky(low, s);
@@ -1082,7 +1170,8 @@ namespace ring
             m_bwt_s.insert_WT(insert_index, s); // POS
             m_bwt_o.insert_C(m_bwt_o.select_C(s + 1), 0);
 
-            return;
+            ++m_n_triples;
+            return true;
         }
 
         low = m_bwt_p.get_C(o) + m_bwt_o.ranky(low, o);
@@ -1101,8 +1190,10 @@ namespace ring
             m_bwt_o.insert_WT(insert_index, o);
             m_bwt_p.insert_C(m_bwt_p.select_C(o + 1), 0);
 
-            return;
+            ++m_n_triples;
+            return true;
         }
+        return false;
     }
 
     /**
@@ -1142,6 +1233,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             // Check if the elements s,p,o are still in use
             bool s_is_used = m_bwt_o.nElems(s);
@@ -1169,6 +1261,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             // Check if the elements s,p,o are still in use
             bool s_is_used = m_bwt_o.nElems(s);
@@ -1196,6 +1289,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             // Check if the elements s,p,o are still in use
             bool s_is_used = m_bwt_o.nElems(s);
@@ -1244,6 +1338,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             return ;
         }
@@ -1266,6 +1361,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             return;
         }
@@ -1288,6 +1384,7 @@ namespace ring
             m_bwt_o.remove_C(m_bwt_o.select_C(s + 1) - 1);
             m_bwt_s.remove_C(m_bwt_s.select_C(p + 1) - 1);
             m_bwt_p.remove_C(m_bwt_p.select_C(o + 1) - 1);
+            --m_n_triples;
 
             return;
         }
@@ -1355,6 +1452,7 @@ namespace ring
             m_bwt_p.remove_C(m_bwt_p.select_C(ret_value + 1) - 1);
         }
 
+        m_n_triples -= total_removed;
         return total_removed;
     }
 
@@ -1443,9 +1541,91 @@ namespace ring
                 m_bwt_p.remove_C(m_bwt_p.select_C(ret_value + 1) - 1);
             }
         }
+        m_n_triples -= total_removed;
         return total_removed;
     }
 
+    /**
+     * @brief Appends all the triples of the ring to D, in SPO order.
+     * The i-th entry of the SPO order holds O in m_bwt_o; its S is given by the
+     * C array of m_bwt_o and its P by the matching entry of the OSP order.
+     *
+     * @param D Vector where the triples are appended
+     */
+    template <class bwt_so_t, class bwt_p_t>
+    void ring<bwt_so_t, bwt_p_t>::get_triples(vector<spo_triple_type> &D)
+    {
+        D.reserve(D.size() + m_n_triples);
+        for (uint64_t i = 1; i <= m_n_triples; i++)
+        {
+            std::pair<uint64_t, uint64_t> r_o = m_bwt_o.inverse_select(i);
+            uint64_t s = m_bwt_o.bsearch_C(i) - 1;
+            uint64_t p = m_bwt_p[m_bwt_p.get_C(r_o.second) + r_o.first];
+            D.emplace_back(s, p, r_o.second);
+        }
+    }
+
+    /**
+     * @brief Renames the IDs in use to the dense ranges 1..n_so and 1..n_p, keeping
+     * their order, and rebuilds the BWTs with the smaller alphabets. Since the
+     * order is kept, only the values of L and the C arrays change.
+     *
+     * @param so_map Returns the new ID of every old subject/object ID (0 if not used)
+     * @param p_map Returns the new ID of every old predicate ID (0 if not used)
+     */
+    template <class bwt_so_t, class bwt_p_t>
+    void ring<bwt_so_t, bwt_p_t>::remap_ids(vector<uint64_t> &so_map, vector<uint64_t> &p_map)
+    {
+        vector<uint64_t> L_o, C_o, L_p, C_p, L_s, C_s;
+        m_bwt_o.decode(L_o, C_o); // C by S, L holds O
+        m_bwt_p.decode(L_p, C_p); // C by O, L holds P
+        m_bwt_s.decode(L_s, C_s); // C by P, L holds S
+
+        auto used = [](const vector<uint64_t> &C, uint64_t v)
+        { return v + 1 < C.size() && C[v + 1] > C[v]; };
+        uint64_t n_so = 0, n_p = 0;
+        so_map.assign(std::max(C_o.size(), C_p.size()) - 1, 0);
+        for (uint64_t v = 1; v < so_map.size(); v++)
+            if (used(C_o, v) || used(C_p, v))
+                so_map[v] = ++n_so;
+        p_map.assign(C_s.size() - 1, 0);
+        for (uint64_t v = 1; v < p_map.size(); v++)
+            if (used(C_s, v))
+                p_map[v] = ++n_p;
+
+        // Maps the values of L and keeps in C only the values still in use
+        auto remap = [](vector<uint64_t> &L, vector<uint64_t> &C, const vector<uint64_t> &L_map,
+                        const vector<uint64_t> &C_map, uint64_t n_C)
+        {
+            for (uint64_t i = 1; i < L.size(); i++)
+                L[i] = L_map[L[i]];
+            vector<uint64_t> new_C(n_C + 2, 0);
+            for (uint64_t v = 1; v < C_map.size(); v++)
+                if (C_map[v])
+                    new_C[C_map[v]] = C[v];
+            new_C[n_C + 1] = C.back();
+            C.swap(new_C);
+        };
+        so_map.resize(std::max(C_o.size(), C_p.size()) - 1, 0);
+        remap(L_o, C_o, so_map, so_map, n_so);
+        remap(L_p, C_p, p_map, so_map, n_so);
+        remap(L_s, C_s, so_map, p_map, n_p);
+
+        m_max_s = m_max_o = n_so;
+        m_max_p = n_p;
+        auto to_int_vector = [](const vector<uint64_t> &L)
+        {
+            int_vector<> res(L.size());
+            for (uint64_t i = 0; i < L.size(); i++)
+                res[i] = L[i];
+            util::bit_compress(res);
+            return res;
+        };
+        m_bwt_o = bwt_so_type(to_int_vector(L_o), C_o, m_max_o);
+        m_bwt_p = bwt_p_type(to_int_vector(L_p), C_p, m_max_p);
+        m_bwt_s = bwt_so_type(to_int_vector(L_s), C_s, m_max_s);
+    }
+
     template <class bwt_so_t, class bwt_p_t>
     uint64_t ring<bwt_so_t, bwt_p_t>::bit_size()
     {
@@ -1459,8 +1639,14 @@ namespace ring
 
     typedef ring<bwt_rrr, bwt_rrr> c_ring;
     typedef ring<bwt_plain, bwt_plain> ring_sel;     // with select
+    typedef ring<bwt_simd, bwt_simd> ring_simd;      // with select, SIMD rank/select kernels
+    typedef ring<bwt_cl, bwt_cl> ring_cl;            // with select, cache-line interleaved bitvectors
+    typedef ring<bwt_plain, bwt_alpha> ring_alpha;   // with select, entropy-shaped predicate BWT
+    typedef ring<bwt_ap, bwt_plain> ring_ap;         // with select, alphabet-partitioned subject/object BWTs
     typedef ring<bwt_dynamic, bwt_dynamic> ring_dyn; // dynamic
     typedef ring<big_bwt, big_bwt> medium_ring_dyn;  // dynamic
+    typedef ring<read_bwt, read_bwt> read_ring_dyn;  // dynamic, large leaves (read-heavy)
+    typedef ring<update_bwt, update_bwt> update_ring_dyn; // dynamic, small leaves (update-heavy)
 
 }
 
@@ -0,0 +1,811 @@
+/*
+ * ring_delta.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_DELTA_HPP
+#define RING_DELTA_HPP
+
+#include <array>
+#include <set>
+#include <memory>
+#include <future>
+#include <chrono>
+#include "ring.hpp"
+#include "triple_pattern.hpp"
+#include "ltj_iterator.hpp"
+#include "utils.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Static ring with a differential layer for updates. Inserted and
+     * deleted triples are kept in small sorted sets (one per component order),
+     * and ltj_iterator merges them with the static ring at query time. Once
+     * the delta reaches the merge threshold a new static ring is built in the
+     * background from the static triples and the delta.
+     *
+     * Invariants: inserted triples are not in the static ring and deleted
+     * triples are.
+     *
+     * The delta sets are an immutable base, shared by the snapshots, and a
+     * tail with the changes made to the base since it was built. Updates only
+     * touch the tail, and freeze() moves the tail into a new base.
+     *
+     * @tparam ring_t Static ring
+     */
+    template <class ring_t = ring<>>
+    class ring_delta {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef ring_t static_ring_type;
+        typedef std::tuple<uint32_t, uint32_t, uint32_t> spo_triple_type;
+        typedef std::array<uint64_t, 3> key_type;   // triple with its components permuted
+        typedef std::set<key_type> delta_set_type;
+
+        static const uint8_t n_orders = 6;
+
+    private:
+        /**
+         * One side of the delta (inserted or deleted triples) in every order: the
+         * triples of the base that are not removed, and those added.
+         */
+        struct delta_type {
+            typedef std::array<delta_set_type, n_orders> sets_type;
+
+            std::shared_ptr<const sets_type> base; // nullptr if empty
+            sets_type added;   // not in base
+            sets_type removed; // in base
+
+            bool in_base(const spo_triple_type &t) const {
+                return base != nullptr && (*base)[0].count(to_key(t, 0)) > 0;
+            }
+
+            bool contains(const spo_triple_type &t) const {
+                if (added[0].count(to_key(t, 0)) > 0) return true;
+                return in_base(t) && removed[0].count(to_key(t, 0)) == 0;
+            }
+
+            void add(const spo_triple_type &t) {
+                if (in_base(t)) ring_delta::erase(removed.data(), t);
+                else ring_delta::add(added.data(), t);
+            }
+
+            void erase(const spo_triple_type &t) {
+                if (in_base(t)) ring_delta::add(removed.data(), t);
+                else ring_delta::erase(added.data(), t);
+            }
+
+            size_type base_size() const {
+                return base == nullptr ? 0 : (*base)[0].size();
+            }
+
+            size_type tail_size() const {
+                return added[0].size() + removed[0].size();
+            }
+
+            size_type size() const {
+                return base_size() + added[0].size() - removed[0].size();
+            }
+
+            size_type count(const uint64_t *values, uint8_t mask) const {
+                size_type n = ring_delta::count(added.data(), values, mask);
+                if (base != nullptr) {
+                    n += ring_delta::count(base->data(), values, mask);
+                    n -= ring_delta::count(removed.data(), values, mask);
+                }
+                return n;
+            }
+
+            //! Smallest key >= low in order k; false if there is none
+            bool lower_bound(uint8_t k, const key_type &low, key_type &res) const {
+                auto it = added[k].lower_bound(low);
+                bool found = it != added[k].end();
+                if (found) res = *it;
+                if (base == nullptr) return found;
+                for (auto jt = (*base)[k].lower_bound(low); jt != (*base)[k].end(); ++jt) {
+                    if (found && res < *jt) break;
+                    if (removed[k].count(*jt) == 0) {
+                        res = *jt;
+                        return true;
+                    }
+                }
+                return found;
+            }
+
+            //! Largest key in order k; false if there is none
+            bool last(uint8_t k, key_type &res) const {
+                bool found = !added[k].empty();
+                if (found) res = *added[k].rbegin();
+                if (base == nullptr) return found;
+                for (auto jt = (*base)[k].rbegin(); jt != (*base)[k].rend(); ++jt) {
+                    if (found && *jt < res) break;
+                    if (removed[k].count(*jt) == 0) {
+                        res = *jt;
+                        return true;
+                    }
+                }
+                return found;
+            }
+
+            //! Appends the triples in SPO order
+            void triples(std::vector<spo_triple_type> &res) const {
+                std::vector<spo_triple_type> in_added, in_base;
+                for (auto &key : added[0]) in_added.push_back(to_triple(key));
+                if (base != nullptr) {
+                    for (auto &key : (*base)[0]) {
+                        if (removed[0].count(key) == 0) in_base.push_back(to_triple(key));
+                    }
+                }
+                std::merge(in_base.begin(), in_base.end(), in_added.begin(), in_added.end(),
+                           std::back_inserter(res));
+            }
+
+            //! Moves the tail into a new base: O(base + tail)
+            void freeze() {
+                if (tail_size() == 0) return;
+                std::shared_ptr<sets_type> b = base == nullptr ? std::make_shared<sets_type>()
+                                                               : std::make_shared<sets_type>(*base);
+                for (uint8_t k = 0; k < n_orders; ++k) {
+                    for (auto &key : removed[k]) (*b)[k].erase(key);
+                    (*b)[k].insert(added[k].begin(), added[k].end());
+                    added[k].clear();
+                    removed[k].clear();
+                }
+                base = b;
+            }
+
+            void clear() {
+                base = nullptr;
+                for (uint8_t k = 0; k < n_orders; ++k) {
+                    added[k].clear();
+                    removed[k].clear();
+                }
+            }
+        };
+
+        std::shared_ptr<ring_t> m_static; // nullptr if the static part is empty
+        delta_type m_inserted;
+        delta_type m_deleted;
+        size_type m_merge_threshold = 1 << 20;
+
+        // Background merge: the delta it was started with and the new static ring
+        std::future<std::shared_ptr<ring_t>> m_merge;
+        std::vector<spo_triple_type> m_merge_inserted;
+        std::vector<spo_triple_type> m_merge_deleted;
+
+        //! Component orders; 0, 1 and 2 stand for S, P and O
+        static const uint8_t *order(uint8_t k) {
+            static const uint8_t orders[n_orders][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2},
+                                                        {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+            return orders[k];
+        }
+
+        //! An order whose first components are those in mask, followed by x (if x < 3)
+        static uint8_t order_for(uint8_t mask, uint8_t x = 3) {
+            uint8_t n_bound = __builtin_popcount(mask);
+            for (uint8_t k = 0; k < n_orders; ++k) {
+                const uint8_t *ord = order(k);
+                bool ok = true;
+                for (uint8_t i = 0; i < n_bound && ok; ++i) {
+                    ok = (mask >> ord[i]) & 1;
+                }
+                if (ok && (x >= 3 || n_bound >= 3 || ord[n_bound] == x)) return k;
+            }
+            return 0;
+        }
+
+        static key_type to_key(const spo_triple_type &t, uint8_t k) {
+            uint64_t v[3] = {std::get<0>(t), std::get<1>(t), std::get<2>(t)};
+            const uint8_t *ord = order(k);
+            return {v[ord[0]], v[ord[1]], v[ord[2]]};
+        }
+
+        static spo_triple_type to_triple(const key_type &key) {
+            return spo_triple_type(key[0], key[1], key[2]);
+        }
+
+        static void add(delta_set_type *sets, const spo_triple_type &t) {
+            for (uint8_t k = 0; k < n_orders; ++k) sets[k].insert(to_key(t, k));
+        }
+
+        static void erase(delta_set_type *sets, const spo_triple_type &t) {
+            for (uint8_t k = 0; k < n_orders; ++k) sets[k].erase(to_key(t, k));
+        }
+
+        //! Triples of sets whose components in mask are equal to those in values
+        static size_type count(const delta_set_type *sets, const uint64_t *values, uint8_t mask) {
+            uint8_t n_bound = __builtin_popcount(mask);
+            if (n_bound == 0) return sets[0].size();
+            uint8_t k = order_for(mask);
+            const uint8_t *ord = order(k);
+            key_type low = {0, 0, 0};
+            for (uint8_t i = 0; i < n_bound; ++i) low[i] = values[ord[i]];
+            size_type n = 0;
+            for (auto it = sets[k].lower_bound(low); it != sets[k].end(); ++it) {
+                bool match = true;
+                for (uint8_t i = 0; i < n_bound && match; ++i) match = (*it)[i] == low[i];
+                if (!match) break;
+                ++n;
+            }
+            return n;
+        }
+
+        bool static_contains(const spo_triple_type &t) {
+            return m_static != nullptr && m_static->contains(t);
+        }
+
+        static std::shared_ptr<ring_t> build(std::shared_ptr<ring_t> base,
+                                             const std::vector<spo_triple_type> &inserted,
+                                             const std::vector<spo_triple_type> &deleted) {
+            std::vector<spo_triple_type> D;
+            if (base != nullptr) base->get_triples(D);
+            // D, inserted and deleted are sorted in SPO order
+            std::vector<spo_triple_type> kept, merged;
+            std::set_difference(D.begin(), D.end(), deleted.begin(), deleted.end(), std::back_inserter(kept));
+            std::vector<spo_triple_type>().swap(D);
+            std::merge(kept.begin(), kept.end(), inserted.begin(), inserted.end(), std::back_inserter(merged));
+            std::vector<spo_triple_type>().swap(kept);
+            if (merged.empty()) return nullptr;
+            return std::make_shared<ring_t>(merged);
+        }
+
+        //! Installs the new static ring and keeps the updates done while it was built
+        void finish_merge() {
+            std::shared_ptr<ring_t> new_static = m_merge.get();
+            std::vector<spo_triple_type> current;
+            m_inserted.triples(current);
+            m_deleted.triples(current);
+            std::set<spo_triple_type> changed(m_merge_inserted.begin(), m_merge_inserted.end());
+            changed.insert(m_merge_deleted.begin(), m_merge_deleted.end());
+            changed.insert(current.begin(), current.end());
+
+            delta_type new_inserted, new_deleted;
+            for (auto &t : changed) {
+                bool in_del = m_deleted.contains(t);
+                bool in_old_del = std::binary_search(m_merge_deleted.begin(), m_merge_deleted.end(), t);
+                bool in_old_static = in_del || in_old_del;
+                bool present = (in_old_static && !in_del) || m_inserted.contains(t);
+                bool in_new_static = (in_old_static && !in_old_del)
+                                     || std::binary_search(m_merge_inserted.begin(), m_merge_inserted.end(), t);
+                if (present && !in_new_static) new_inserted.add(t);
+                if (!present && in_new_static) new_deleted.add(t);
+            }
+            m_static = new_static;
+            m_inserted = std::move(new_inserted);
+            m_deleted = std::move(new_deleted);
+            std::vector<spo_triple_type>().swap(m_merge_inserted);
+            std::vector<spo_triple_type>().swap(m_merge_deleted);
+        }
+
+        void check_merge() {
+            if (merging() && m_merge.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                finish_merge();
+            }
+            if (!merging() && delta_size() >= m_merge_threshold) {
+                start_merge();
+            }
+        }
+
+        void copy(const ring_delta &o) {
+            m_static = o.m_static == nullptr ? nullptr : std::make_shared<ring_t>(*o.m_static);
+            m_inserted = o.m_inserted;
+            m_deleted = o.m_deleted;
+            m_merge_threshold = o.m_merge_threshold;
+        }
+
+    public:
+        ring_delta() = default;
+
+        ring_delta(vector<spo_triple_type> &D) {
+            if (!D.empty()) m_static = std::make_shared<ring_t>(D);
+        }
+
+        ~ring_delta() {
+            if (merging()) m_merge.wait();
+        }
+
+        //! Copy constructor (a running merge of o is not copied)
+        ring_delta(const ring_delta &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        ring_delta(ring_delta &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        ring_delta &operator=(const ring_delta &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        ring_delta &operator=(ring_delta &&o) {
+            if (this != &o) {
+                m_static = std::move(o.m_static);
+                m_inserted = std::move(o.m_inserted);
+                m_deleted = std::move(o.m_deleted);
+                m_merge_threshold = o.m_merge_threshold;
+                m_merge = std::move(o.m_merge);
+                m_merge_inserted = std::move(o.m_merge_inserted);
+                m_merge_deleted = std::move(o.m_merge_deleted);
+            }
+            return *this;
+        }
+
+        void swap(ring_delta &o) {
+            std::swap(m_static, o.m_static);
+            std::swap(m_inserted, o.m_inserted);
+            std::swap(m_deleted, o.m_deleted);
+            std::swap(m_merge_threshold, o.m_merge_threshold);
+            std::swap(m_merge, o.m_merge);
+            m_merge_inserted.swap(o.m_merge_inserted);
+            m_merge_deleted.swap(o.m_merge_deleted);
+        }
+
+        //! Serializes the static ring and the delta
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            uint8_t has_static = m_static != nullptr;
+            written_bytes += sdsl::write_member(has_static, out, child, "has_static");
+            if (has_static) written_bytes += m_static->serialize(out, child, "static");
+            const delta_type *deltas[2] = {&m_inserted, &m_deleted};
+            for (auto delta : deltas) {
+                std::vector<spo_triple_type> triples;
+                delta->triples(triples);
+                uint64_t n = triples.size();
+                written_bytes += sdsl::write_member(n, out, child, "n_delta");
+                for (auto &t : triples) {
+                    key_type key = to_key(t, 0);
+                    for (uint8_t i = 0; i < 3; ++i) {
+                        written_bytes += sdsl::write_member(key[i], out, child, "component");
+                    }
+                }
+            }
+            written_bytes += sdsl::write_member(m_merge_threshold, out, child, "merge_threshold");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            uint8_t has_static;
+            sdsl::read_member(has_static, in);
+            m_static = nullptr;
+            if (has_static) {
+                m_static = std::make_shared<ring_t>();
+                m_static->load(in);
+            }
+            delta_type *deltas[2] = {&m_inserted, &m_deleted};
+            for (auto delta : deltas) {
+                uint64_t n;
+                sdsl::read_member(n, in);
+                delta->clear();
+                for (uint64_t j = 0; j < n; ++j) {
+                    key_type key;
+                    for (uint8_t i = 0; i < 3; ++i) sdsl::read_member(key[i], in);
+                    delta->add(to_triple(key));
+                }
+            }
+            sdsl::read_member(m_merge_threshold, in);
+        }
+
+        //! Inserts a triple; does nothing if it is already stored
+        void insert(spo_triple_type triple) {
+            if (m_inserted.contains(triple)) return;
+            if (m_deleted.contains(triple)) {
+                m_deleted.erase(triple);
+            } else if (!static_contains(triple)) {
+                m_inserted.add(triple);
+            }
+            check_merge();
+        }
+
+        //! Removes a triple; does nothing if it is not stored
+        void remove_edge(spo_triple_type triple) {
+            if (m_inserted.contains(triple)) {
+                m_inserted.erase(triple);
+            } else if (!m_deleted.contains(triple) && static_contains(triple)) {
+                m_deleted.add(triple);
+            }
+            check_merge();
+        }
+
+        //! Number of triples
+        size_type n_triples() const {
+            size_type n = m_static == nullptr ? 0 : m_static->n_triples();
+            return n + m_inserted.size() - m_deleted.size();
+        }
+
+        size_type delta_size() const {
+            return m_inserted.size() + m_deleted.size();
+        }
+
+        //! Changes of the delta since the last freeze()
+        size_type tail_size() const {
+            return m_inserted.tail_size() + m_deleted.tail_size();
+        }
+
+        //! Triples of the delta in its shared base
+        size_type base_size() const {
+            return m_inserted.base_size() + m_deleted.base_size();
+        }
+
+        //! Moves the changes of the delta into a new base, shared by later snapshots
+        void freeze() {
+            m_inserted.freeze();
+            m_deleted.freeze();
+        }
+
+        //! Size of the subject/object alphabet, inserted triples included
+        size_type max_so() const {
+            size_type res = m_static == nullptr ? 0 : m_static->max_so();
+            key_type key;
+            if (m_inserted.last(0, key)) res = std::max<size_type>(res, key[0]); // S first
+            if (m_inserted.last(4, key)) res = std::max<size_type>(res, key[0]); // O first
+            return res;
+        }
+
+        //! Size of the predicate alphabet, inserted triples included
+        size_type max_p() const {
+            size_type res = m_static == nullptr ? 0 : m_static->max_p();
+            key_type key;
+            if (m_inserted.last(2, key)) res = std::max<size_type>(res, key[0]); // P first
+            return res;
+        }
+
+        void set_merge_threshold(size_type threshold) {
+            m_merge_threshold = threshold;
+        }
+
+        bool merging() const {
+            return m_merge.valid();
+        }
+
+        //! Starts building a new static ring with the current delta in the background
+        void start_merge() {
+            if (merging()) return;
+            m_inserted.triples(m_merge_inserted);
+            m_deleted.triples(m_merge_deleted);
+            m_merge = std::async(std::launch::async, &ring_delta::build, m_static,
+                                 m_merge_inserted, m_merge_deleted);
+        }
+
+        //! Blocks until the running merge (if any) is installed
+        void wait_merge() {
+            if (merging()) finish_merge();
+        }
+
+        //! Folds the whole delta into the static ring
+        void merge() {
+            wait_merge();
+            if (delta_size() == 0) return;
+            start_merge();
+            finish_merge();
+        }
+
+        void get_triples(vector<spo_triple_type> &D) {
+            std::vector<spo_triple_type> inserted, deleted;
+            m_inserted.triples(inserted);
+            m_deleted.triples(deleted);
+            std::shared_ptr<ring_t> all = build(m_static, inserted, deleted);
+            if (all != nullptr) all->get_triples(D);
+        }
+
+        /**
+         * Copy that shares the static ring and the base of the delta, so only the
+         * tail is copied; later updates of this object do not affect it
+         */
+        ring_delta snapshot() const {
+            ring_delta res;
+            res.m_static = m_static;
+            res.m_inserted = m_inserted;
+            res.m_deleted = m_deleted;
+            res.m_merge_threshold = m_merge_threshold;
+            return res;
+        }
+
+        //! Static part of the index (nullptr if empty)
+        ring_t *static_ring() const {
+            return m_static.get();
+        }
+
+        /**
+         * @brief Smallest value >= c of component x among the inserted triples whose
+         * components in mask are equal to those in values. Returns 0 if there is none.
+         */
+        value_type next_inserted(const uint64_t *values, uint8_t mask, uint8_t x, value_type c) const {
+            uint8_t k = order_for(mask, x);
+            const uint8_t *ord = order(k);
+            uint8_t n_bound = __builtin_popcount(mask);
+            key_type low = {0, 0, 0};
+            for (uint8_t i = 0; i < n_bound; ++i) low[i] = values[ord[i]];
+            low[n_bound] = c;
+            key_type key;
+            if (!m_inserted.lower_bound(k, low, key)) return 0;
+            for (uint8_t i = 0; i < n_bound; ++i) {
+                if (key[i] != low[i]) return 0;
+            }
+            return key[n_bound];
+        }
+
+        size_type count_inserted(const uint64_t *values, uint8_t mask) const {
+            return m_inserted.count(values, mask);
+        }
+
+        size_type count_deleted(const uint64_t *values, uint8_t mask) const {
+            return m_deleted.count(values, mask);
+        }
+
+        bool has_deleted() const {
+            return m_deleted.size() > 0;
+        }
+    };
+
+    /**
+     * @brief ltj_iterator over a ring_delta. Leaps are answered by an iterator
+     * over the static ring, skipping values whose triples are all deleted, and
+     * by the inserted triples; the result is the smaller of both. Once the
+     * current prefix has no live triples in the static ring, only the delta
+     * is used until going up again.
+     */
+    template <class ring_t, class var_t, class cons_t>
+    class ltj_iterator<ring_delta<ring_t>, var_t, cons_t> {
+
+    public:
+        typedef cons_t value_type;
+        typedef var_t var_type;
+        typedef ring_delta<ring_t> ring_type;
+        typedef uint64_t size_type;
+        typedef ltj_iterator<ring_t, var_t, cons_t> static_iter_type;
+
+    private:
+        const triple_pattern *m_ptr_triple_pattern;
+        ring_type *m_ptr_ring;
+        static_iter_type m_static;
+        bool m_static_alive = false;
+        uint8_t m_depth = 0;
+        uint8_t m_alive_stack = 0;          // bit d: m_static_alive before the d-th down
+        uint8_t m_down_stack = 0;           // bit d: the d-th down went down in m_static
+        var_type m_last_var;                // last leap answered by the static ring
+        value_type m_last_static = 0;
+        uint64_t m_cur[3] = {(uint64_t) -1, (uint64_t) -1, (uint64_t) -1};
+        bwt_interval m_i_s, m_i_p, m_i_o;   // only their sizes are meaningful
+        bool m_is_empty = false;
+
+    public:
+        //! The intervals are not updated by down(): their sizes are those of the initial prefix
+        static const bool exact_intervals = false;
+
+    private:
+
+        void copy(const ltj_iterator &o) {
+            m_ptr_triple_pattern = o.m_ptr_triple_pattern;
+            m_ptr_ring = o.m_ptr_ring;
+            m_static = o.m_static;
+            m_static_alive = o.m_static_alive;
+            m_depth = o.m_depth;
+            m_alive_stack = o.m_alive_stack;
+            m_down_stack = o.m_down_stack;
+            m_last_var = o.m_last_var;
+            m_last_static = o.m_last_static;
+            std::copy(o.m_cur, o.m_cur + 3, m_cur);
+            m_i_s = o.m_i_s;
+            m_i_p = o.m_i_p;
+            m_i_o = o.m_i_o;
+            m_is_empty = o.m_is_empty;
+        }
+
+        //! Component (0: S, 1: P, 2: O) of var in the triple pattern, 3 if none
+        inline uint8_t component(var_type var) const {
+            if (m_ptr_triple_pattern->term_s.is_variable && var == m_ptr_triple_pattern->term_s.value) return 0;
+            if (m_ptr_triple_pattern->term_p.is_variable && var == m_ptr_triple_pattern->term_p.value) return 1;
+            if (m_ptr_triple_pattern->term_o.is_variable && var == m_ptr_triple_pattern->term_o.value) return 2;
+            return 3;
+        }
+
+        inline uint8_t mask() const {
+            return (m_cur[0] != (uint64_t) -1) | ((m_cur[1] != (uint64_t) -1) << 1)
+                   | ((m_cur[2] != (uint64_t) -1) << 2);
+        }
+
+        //! Static triples under the current prefix; requires m_static_alive
+        size_type static_count(const static_iter_type &iter, uint8_t m) const {
+            return m == 7 ? 1 : util::get_size_interval(iter);
+        }
+
+        //! Whether the static ring has non-deleted triples under the prefix extended with x = v
+        bool static_live(var_type var, uint8_t x, value_type v) {
+            uint64_t values[3] = {m_cur[0], m_cur[1], m_cur[2]};
+            values[x] = v;
+            uint8_t m = mask() | (1 << x);
+            size_type n_deleted = m_ptr_ring->count_deleted(values, m);
+            if (n_deleted == 0) return true;
+            if (m == 7) return false;
+            static_iter_type iter = m_static;
+            iter.down(var, v);
+            return static_count(iter, m) > n_deleted;
+        }
+
+        value_type static_next(var_type var, uint8_t x, value_type c) {
+            if (!m_static_alive) return 0;
+            value_type v = (c == (value_type) -1) ? m_static.leap(var) : m_static.leap(var, c);
+            while (v != 0 && m_ptr_ring->has_deleted() && !static_live(var, x, v)) {
+                v = m_static.leap(var, v + 1);
+            }
+            m_last_var = var;
+            m_last_static = v;
+            return v;
+        }
+
+        value_type next(var_type var, value_type c) {
+            uint8_t x = component(var);
+            if (x == 3) return 0;
+            value_type v_s = static_next(var, x, c);
+            value_type v_d = m_ptr_ring->next_inserted(m_cur, mask(), x, c == (value_type) -1 ? 0 : c);
+            if (v_s == 0) return v_d;
+            if (v_d == 0) return v_s;
+            return std::min(v_s, v_d);
+        }
+
+    public:
+        const bool &is_empty = m_is_empty;
+        const bwt_interval &i_s = m_i_s;
+        const bwt_interval &i_p = m_i_p;
+        const bwt_interval &i_o = m_i_o;
+        const value_type &cur_s = m_cur[0];
+        const value_type &cur_p = m_cur[1];
+        const value_type &cur_o = m_cur[2];
+
+        ltj_iterator() = default;
+
+        //! The cache is not used: the static ring is replaced by merges
+        ltj_iterator(const triple_pattern *triple, ring_type *ring, interval_cache *cache = nullptr) {
+            m_ptr_triple_pattern = triple;
+            m_ptr_ring = ring;
+            if (!triple->s_is_variable()) m_cur[0] = triple->term_s.value;
+            if (!triple->p_is_variable()) m_cur[1] = triple->term_p.value;
+            if (!triple->o_is_variable()) m_cur[2] = triple->term_o.value;
+            uint8_t m = mask();
+
+            size_type n_static = 0;
+            if (m_ptr_ring->static_ring() != nullptr) {
+                m_static = static_iter_type(triple, m_ptr_ring->static_ring());
+                if (!m_static.is_empty) {
+                    n_static = static_count(m_static, m) - m_ptr_ring->count_deleted(m_cur, m);
+                    m_static_alive = n_static > 0;
+                }
+            }
+            size_type n = n_static + m_ptr_ring->count_inserted(m_cur, m);
+            m_is_empty = n == 0;
+            m_i_s = m_i_p = m_i_o = bwt_interval(1, n);
+        }
+
+        //! Copy constructor
+        ltj_iterator(const ltj_iterator &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        ltj_iterator(ltj_iterator &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        ltj_iterator &operator=(const ltj_iterator &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        ltj_iterator &operator=(ltj_iterator &&o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        void swap(ltj_iterator &o) {
+            ltj_iterator aux(o);
+            o = *this;
+            *this = aux;
+        }
+
+        //! See the ltj_iterator of the static ring; the merged intervals are never overwritten
+        void keep_intervals(const bool keep) {
+            m_static.keep_intervals(keep);
+        }
+
+        void down(var_type var, size_type c) { //Go down in the trie
+            uint8_t x = component(var);
+            if (x == 3) return;
+            m_alive_stack = (m_alive_stack & ~(1 << m_depth)) | (m_static_alive << m_depth);
+            m_down_stack &= ~(1 << m_depth);
+            if (m_static_alive && !in_last_level()) {
+                if ((m_last_var == var && m_last_static == c)
+                    || (m_static.leap(var, c) == c && static_live(var, x, c))) {
+                    m_static.down(var, c);
+                    m_down_stack |= 1 << m_depth;
+                } else {
+                    m_static_alive = false;
+                }
+            }
+            ++m_depth;
+            m_cur[x] = c;
+            m_last_static = 0;
+        }
+
+        void up(var_type var) { //Go up in the trie
+            uint8_t x = component(var);
+            if (x == 3) return;
+            --m_depth;
+            if ((m_down_stack >> m_depth) & 1) m_static.up(var);
+            m_static_alive = (m_alive_stack >> m_depth) & 1;
+            m_cur[x] = -1;
+            m_last_static = 0;
+        }
+
+        value_type leap(var_type var) { //Return the minimum in the range
+            return next(var, -1);
+        }
+
+        value_type leap(var_type var, size_type c) { //Return the next value greater or equal than c in the range
+            return next(var, c);
+        }
+
+        bool in_last_level() {
+            return __builtin_popcount(mask()) >= 2;
+        }
+
+        //Only works in the last level
+        std::vector<uint64_t> seek_all(var_type var) {
+            std::vector<uint64_t> res;
+            uint8_t x = component(var);
+            if (x == 3) return res;
+            if (m_static_alive) {
+                res = m_static.seek_all(var);
+                if (m_ptr_ring->has_deleted()) {
+                    uint64_t values[3] = {m_cur[0], m_cur[1], m_cur[2]};
+                    auto end = std::remove_if(res.begin(), res.end(), [&](uint64_t v) {
+                        values[x] = v;
+                        return m_ptr_ring->count_deleted(values, 7) > 0;
+                    });
+                    res.erase(end, res.end());
+                }
+            }
+            uint8_t m = mask();
+            value_type v = m_ptr_ring->next_inserted(m_cur, m, x, 0);
+            while (v != 0) {
+                res.push_back(v);
+                v = m_ptr_ring->next_inserted(m_cur, m, x, v + 1);
+            }
+            std::sort(res.begin(), res.end());
+            res.erase(std::unique(res.begin(), res.end()), res.end());
+            return res;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * ring_versioned.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_VERSIONED_HPP
+#define RING_VERSIONED_HPP
+
+#include <atomic>
+#include <memory>
+#include "ring_delta.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Multi-version ring for one writer and many readers. The writer
+     * updates a private ring_delta and publishes immutable versions of it;
+     * readers pin the last published version and query it while the writer
+     * goes on. Versions share the static ring and the base of the delta,
+     * and only copy its tail (see ring_delta). Publishing never blocks readers.
+     *
+     * Only ring_delta is versioned: the dynamic rings (e.g. medium_ring_dyn)
+     * and the dictionaries (dict_map) are not, so terms have to be mapped
+     * before the writer starts.
+     *
+     * @tparam ring_t Static ring
+     */
+    template <class ring_t = ring<>>
+    class ring_versioned {
+
+    public:
+        typedef uint64_t size_type;
+        typedef ring_delta<ring_t> version_type;
+        typedef std::shared_ptr<version_type> version_ptr; // must be used as read-only
+        typedef typename version_type::spo_triple_type spo_triple_type;
+
+    private:
+        version_type m_writer;
+        version_ptr m_current;
+        std::atomic<uint64_t> m_version{0};
+        size_type m_pending = 0; // updates not published yet
+
+        void copy(const ring_versioned &o) {
+            m_writer = o.m_writer;
+            m_current = o.pin();
+            m_version = o.m_version.load();
+            m_pending = o.m_pending;
+        }
+
+    public:
+        ring_versioned() {
+            publish();
+        }
+
+        ring_versioned(vector<spo_triple_type> &D) : m_writer(D) {
+            publish();
+        }
+
+        //! Copy constructor
+        ring_versioned(const ring_versioned &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        ring_versioned(ring_versioned &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        ring_versioned &operator=(const ring_versioned &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        ring_versioned &operator=(ring_versioned &&o) {
+            if (this != &o) {
+                m_writer = std::move(o.m_writer);
+                std::atomic_store(&m_current, o.pin());
+                m_version = o.m_version.load();
+                m_pending = o.m_pending;
+            }
+            return *this;
+        }
+
+        //! Serializes the writer state (published or not)
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = m_writer.serialize(out, child, "writer");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            m_writer.load(in);
+            publish();
+        }
+
+        //! Last published version; it stays valid while the pointer is held
+        version_ptr pin() const {
+            return std::atomic_load(&m_current);
+        }
+
+        uint64_t version() const {
+            return m_version.load();
+        }
+
+        //! Writer only. Not visible to readers until publish()
+        void insert(spo_triple_type triple) {
+            m_writer.insert(triple);
+            ++m_pending;
+        }
+
+        //! Writer only. Not visible to readers until publish()
+        void remove_edge(spo_triple_type triple) {
+            m_writer.remove_edge(triple);
+            ++m_pending;
+        }
+
+        /**
+         * Writer only. Makes the updates done so far visible to new readers.
+         * Every version copies the tail of the delta, so the tail is moved into
+         * the shared base once tail^2 > base * pending. That balances both
+         * copies: publishing k updates costs O(sqrt(delta * k)) instead of O(delta).
+         */
+        void publish() {
+            size_type tail = m_writer.tail_size();
+            if (tail * tail > m_writer.base_size() * std::max<size_type>(m_pending, 1)) m_writer.freeze();
+            std::atomic_store(&m_current, std::make_shared<version_type>(m_writer.snapshot()));
+            ++m_version;
+            m_pending = 0;
+        }
+
+        size_type pending() const {
+            return m_pending;
+        }
+
+        //! Writer state, e.g. to tune merges
+        version_type &writer() {
+            return m_writer;
+        }
+    };
+}
+
+#endif
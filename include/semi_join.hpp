@@ -0,0 +1,275 @@
+/*
+ * semi_join.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_SEMI_JOIN_HPP
+#define RING_SEMI_JOIN_HPP
+
+#include <ring.hpp>
+#include <ltj_iterator.hpp>
+#include <utils.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace ring {
+
+    /**
+     * @brief Semi-join reduction (Yannakakis) of an acyclic BGP. Each variable
+     * gets a bitmap of its candidate values, starting with its values in its
+     * smallest pattern. Over each tree of the variables (related by the
+     * patterns with two variables), a bottom-up pass removes from a parent the
+     * values without a partner among the candidates of a child, and a top-down
+     * pass does the same from parents to children. The partners of each
+     * candidate are enumerated with the iterator of the pattern.
+     *
+     * Queries with a pattern of three variables or with a cycle are not reduced.
+     */
+    template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t>
+    class semi_join {
+
+    public:
+        typedef var_t var_type;
+        typedef cons_t value_type;
+        typedef uint64_t size_type;
+        typedef ring_t ring_type;
+        typedef ltj_iterator<ring_type, var_type, value_type> ltj_iter_type;
+        typedef sdsl::bit_vector bitmap_type;
+
+    private:
+        typedef struct {
+            var_type to;
+            std::vector<size_type> patterns;
+        } edge_type;
+
+        const std::vector<triple_pattern> *m_ptr_triple_patterns;
+        ring_type *m_ptr_ring;
+        std::vector<bitmap_type> m_candidates;       // by variable
+        std::vector<std::vector<edge_type>> m_edges; // by variable
+        bool m_acyclic = false;
+        bool m_empty = false;
+
+        static void vars_of(const triple_pattern &triple, std::vector<var_type> &vars) {
+            vars.clear();
+            if (triple.s_is_variable()) vars.push_back((var_type) triple.term_s.value);
+            if (triple.p_is_variable()) vars.push_back((var_type) triple.term_p.value);
+            if (triple.o_is_variable()) vars.push_back((var_type) triple.term_o.value);
+            std::sort(vars.begin(), vars.end());
+            vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+        }
+
+        static var_type find(std::vector<var_type> &parent, var_type v) {
+            while (parent[v] != v) v = parent[v] = parent[parent[v]];
+            return v;
+        }
+
+        //! Values of var in the i-th pattern
+        bitmap_type values(const size_type i, const var_type var) {
+            ltj_iter_type iter(&m_ptr_triple_patterns->at(i), m_ptr_ring);
+            if (iter.is_empty) return bitmap_type(0);
+            std::vector<value_type> vals;
+            for (value_type c = iter.leap(var); c != 0; c = iter.leap(var, c + 1)) {
+                vals.push_back(c);
+            }
+            bitmap_type bm(vals.empty() ? 0 : vals.back() + 1, 0);
+            for (const auto c : vals) bm[c] = 1;
+            return bm;
+        }
+
+        //! bm &= other, other can be shorter
+        static void intersect(bitmap_type &bm, const bitmap_type &other) {
+            uint64_t *w = bm.data();
+            const uint64_t *o = other.data();
+            size_type n = (bm.size() + 63) >> 6, m = (other.size() + 63) >> 6;
+            for (size_type k = 0; k < n; ++k) {
+                w[k] = k < m ? w[k] & o[k] : 0;
+            }
+        }
+
+        static bool is_zero(const bitmap_type &bm) {
+            return next(bm, 0) == 0;
+        }
+
+        //! Keeps in the candidates of a the values with a partner among the candidates of e.to
+        void reduce(const var_type a, const edge_type &e) {
+            const var_type b = e.to;
+            bitmap_type &dom_a = m_candidates[a];
+            const bitmap_type &dom_b = m_candidates[b];
+            for (const auto i : e.patterns) {
+                bitmap_type support(dom_a.size(), 0);
+                ltj_iter_type iter(&m_ptr_triple_patterns->at(i), m_ptr_ring);
+                value_type c = iter.is_empty ? 0 : next(dom_b, 0);
+                if (c != 0) c = iter.leap(b, c);
+                while (c != 0) { //Leapfrog between the pattern and the candidates of b
+                    value_type d = next(dom_b, c);
+                    if (d == 0) break;
+                    if (d != c) {
+                        c = iter.leap(b, d);
+                        continue;
+                    }
+                    iter.down(b, c);
+                    for (value_type x = iter.leap(a); x != 0 && x < support.size(); x = iter.leap(a, x + 1)) {
+                        if (dom_a[x]) support[x] = 1;
+                    }
+                    iter.up(b);
+                    c = iter.leap(b, c + 1);
+                }
+                intersect(dom_a, support);
+            }
+            if (is_zero(dom_a)) m_empty = true;
+        }
+
+        void walk(const var_type v, const var_type parent, std::vector<std::pair<var_type, var_type>> &order) {
+            order.push_back({v, parent});
+            for (const auto &e : m_edges[v]) {
+                if (e.to != parent) walk(e.to, v, order);
+            }
+        }
+
+        const edge_type &edge(const var_type from, const var_type to) const {
+            for (const auto &e : m_edges[from]) {
+                if (e.to == to) return e;
+            }
+            return m_edges[from][0];
+        }
+
+    public:
+
+        semi_join() = default;
+
+        /**
+         *
+         * @param triple_patterns   Triple patterns of the query
+         * @param ring              Index
+         */
+        semi_join(const std::vector<triple_pattern> *triple_patterns, ring_type *ring) {
+            m_ptr_triple_patterns = triple_patterns;
+            m_ptr_ring = ring;
+
+            //1. Patterns of each variable and edges between pairs of variables
+            std::vector<var_type> vars;
+            size_type max_var = 0;
+            for (const auto &triple : *m_ptr_triple_patterns) {
+                vars_of(triple, vars);
+                if (vars.size() == 3) return;
+                for (const auto v : vars) max_var = std::max<size_type>(max_var, v);
+            }
+            std::vector<std::vector<size_type>> var_patterns(max_var + 1);
+            std::vector<var_type> parent(max_var + 1);
+            for (size_type v = 0; v <= max_var; ++v) parent[v] = (var_type) v;
+            m_edges.resize(max_var + 1);
+            for (size_type i = 0; i < m_ptr_triple_patterns->size(); ++i) {
+                vars_of(m_ptr_triple_patterns->at(i), vars);
+                for (const auto v : vars) var_patterns[v].push_back(i);
+                if (vars.size() != 2) continue;
+                auto it = std::find_if(m_edges[vars[0]].begin(), m_edges[vars[0]].end(),
+                                       [&vars](const edge_type &e) { return e.to == vars[1]; });
+                if (it != m_edges[vars[0]].end()) { //Another pattern of the same pair
+                    it->patterns.push_back(i);
+                    for (auto &e : m_edges[vars[1]]) {
+                        if (e.to == vars[0]) e.patterns.push_back(i);
+                    }
+                    continue;
+                }
+                var_type r0 = find(parent, vars[0]), r1 = find(parent, vars[1]);
+                if (r0 == r1) return; //Cycle
+                parent[r0] = r1;
+                m_edges[vars[0]].push_back({vars[1], {i}});
+                m_edges[vars[1]].push_back({vars[0], {i}});
+            }
+            m_acyclic = true;
+
+            //2. Initial candidates: values in the smallest pattern, and in the patterns of one variable
+            m_candidates.resize(max_var + 1);
+            for (size_type v = 0; v <= max_var; ++v) {
+                if (var_patterns[v].empty()) continue;
+                size_type best = var_patterns[v][0], best_size = -1ULL;
+                for (const auto i : var_patterns[v]) {
+                    ltj_iter_type iter(&m_ptr_triple_patterns->at(i), m_ptr_ring);
+                    size_type size = iter.is_empty ? 0 : util::get_size_interval(iter);
+                    if (size < best_size) {
+                        best = i;
+                        best_size = size;
+                    }
+                }
+                m_candidates[v] = values(best, (var_type) v);
+                for (const auto i : var_patterns[v]) {
+                    vars_of(m_ptr_triple_patterns->at(i), vars);
+                    if (i != best && vars.size() == 1) intersect(m_candidates[v], values(i, (var_type) v));
+                }
+                if (is_zero(m_candidates[v])) {
+                    m_empty = true;
+                    return;
+                }
+            }
+
+            //3. Bottom-up and top-down passes over each tree
+            std::vector<bool> visited(max_var + 1, false);
+            std::vector<std::pair<var_type, var_type>> order;
+            for (size_type root = 0; root <= max_var; ++root) {
+                if (var_patterns[root].empty() || visited[root]) continue;
+                order.clear();
+                walk((var_type) root, (var_type) root, order);
+                for (const auto &p : order) visited[p.first] = true;
+                for (auto it = order.rbegin(); it != order.rend() && !m_empty; ++it) {
+                    if (it->first != it->second) reduce(it->second, edge(it->second, it->first));
+                }
+                for (auto it = order.begin(); it != order.end() && !m_empty; ++it) {
+                    if (it->first != it->second) reduce(it->first, edge(it->first, it->second));
+                }
+                if (m_empty) return;
+            }
+        }
+
+        //! False if the query was not reduced
+        inline bool acyclic() const {
+            return m_acyclic;
+        }
+
+        //! True if some variable has no candidates: the query has no results
+        inline bool empty() const {
+            return m_empty;
+        }
+
+        //! Candidates of each variable; empty bitmaps for the variables not in the query
+        std::vector<bitmap_type> &candidates() {
+            return m_candidates;
+        }
+
+        //! Next value of bm greater or equal than c, 0 if there is none
+        static value_type next(const bitmap_type &bm, const value_type c) {
+            if (c >= bm.size()) return 0;
+            const uint64_t *w = bm.data();
+            size_type k = c >> 6, n = (bm.size() + 63) >> 6;
+            uint64_t word = w[k] & (~0ULL << (c & 63));
+            while (true) {
+                if (word) {
+                    value_type r = (k << 6) + __builtin_ctzll(word);
+                    return r < bm.size() ? r : 0;
+                }
+                if (++k >= n) return 0;
+                word = w[k];
+            }
+        }
+
+        static inline bool contains(const bitmap_type &bm, const value_type c) {
+            return c < bm.size() && bm[c];
+        }
+    };
+}
+
+#endif
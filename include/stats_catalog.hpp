@@ -0,0 +1,428 @@
+/*
+ * stats_catalog.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_STATS_CATALOG_HPP
+#define RING_STATS_CATALOG_HPP
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <ring.hpp>
+#include <triple_pattern.hpp>
+#include <ltj_iterator.hpp>
+#include <utils.hpp>
+
+namespace ring {
+
+    /**
+     * @brief Statistics of the predicates of a ring, built with the index and
+     * stored next to it (<index>.stats). For each predicate it keeps the number
+     * of triples and of distinct subjects and objects; for each pair of
+     * predicates, the number of nodes that are subject of both (star joins) and
+     * the number of nodes that are object of the first and subject of the
+     * second (path joins).
+     *
+     * All the statistics are sums over the nodes of the graph of a function of
+     * the predicates of their outgoing and incoming edges, so an update is
+     * accounted by subtracting the profile of the nodes it touches before
+     * applying it and adding their new profile afterwards.
+     *
+     * The pairs of a node cost the square of its predicates, so they are only
+     * counted over its max_pair_predicates predicates with most triples (and
+     * the first ones of its incoming edges): for nodes with more predicates,
+     * the star and path counts are lower bounds. build-index only builds the
+     * catalog on request, and without it the updates do not maintain it.
+     */
+    class stats_catalog {
+
+    public:
+        typedef uint64_t size_type;
+        typedef std::pair<uint64_t, uint64_t> pair_type;
+        typedef std::map<pair_type, size_type> pair_map_type;
+
+        static const size_type max_pair_predicates = 32; // per node and direction
+
+    private:
+        //! Predicates of the edges of a node; out holds (predicate, triples)
+        struct node_profile {
+            std::vector<pair_type> out;
+            std::vector<uint64_t> in;
+        };
+
+        size_type m_n_triples = 0;
+        std::vector<size_type> m_triples;  // per predicate
+        std::vector<size_type> m_subjects; // distinct subjects per predicate
+        std::vector<size_type> m_objects;  // distinct objects per predicate
+        pair_map_type m_star; // (p1 < p2) -> nodes subject of p1 and p2
+        pair_map_type m_path; // (p1, p2) -> nodes object of p1 and subject of p2
+
+        void copy(const stats_catalog &o) {
+            m_n_triples = o.m_n_triples;
+            m_triples = o.m_triples;
+            m_subjects = o.m_subjects;
+            m_objects = o.m_objects;
+            m_star = o.m_star;
+            m_path = o.m_path;
+        }
+
+        void grow(const uint64_t p) {
+            if (p >= m_triples.size()) {
+                m_triples.resize(p + 1, 0);
+                m_subjects.resize(p + 1, 0);
+                m_objects.resize(p + 1, 0);
+            }
+        }
+
+        static void add_pair(pair_map_type &m, const pair_type &key, const int64_t sign) {
+            auto it = m.insert({key, 0}).first;
+            it->second += sign;
+            if (it->second == 0) m.erase(it);
+        }
+
+        static size_type get_pair(const pair_map_type &m, const pair_type &key) {
+            auto it = m.find(key);
+            return it == m.end() ? 0 : it->second;
+        }
+
+        //! Adds (sign = 1) or subtracts (sign = -1) the contribution of a node
+        void add(const node_profile &np, const int64_t sign) {
+            for (const auto &e : np.out) {
+                grow(e.first);
+                m_triples[e.first] += sign * (int64_t) e.second;
+                m_subjects[e.first] += sign;
+                m_n_triples += sign * (int64_t) e.second;
+            }
+            for (const auto p : np.in) {
+                grow(p);
+                m_objects[p] += sign;
+            }
+            //Pairs over the predicates with most triples (the same ones when the profile is subtracted)
+            std::vector<uint64_t> out;
+            for (const auto &e : np.out) out.push_back(e.first);
+            if (out.size() > max_pair_predicates) {
+                std::vector<pair_type> by_triples(np.out);
+                std::sort(by_triples.begin(), by_triples.end(), [](const pair_type &a, const pair_type &b) {
+                    return a.second != b.second ? a.second > b.second : a.first < b.first;
+                });
+                out.clear();
+                for (size_type k = 0; k < max_pair_predicates; ++k) out.push_back(by_triples[k].first);
+                std::sort(out.begin(), out.end());
+            }
+            size_type n_in = std::min<size_type>(np.in.size(), max_pair_predicates);
+            for (size_type i = 0; i < out.size(); ++i) {
+                for (size_type j = i + 1; j < out.size(); ++j) {
+                    add_pair(m_star, {out[i], out[j]}, sign);
+                }
+            }
+            for (size_type i = 0; i < n_in; ++i) {
+                for (const auto p2 : out) {
+                    add_pair(m_path, {np.in[i], p2}, sign);
+                }
+            }
+        }
+
+        template <class ring_t>
+        static node_profile profile(ring_t &graph, const uint64_t v) {
+            typedef ltj_iterator<ring_t, uint8_t, uint64_t> iter_type;
+            node_profile np;
+            triple_pattern out_tp, in_tp;
+            out_tp.const_s(v);
+            out_tp.var_p(0);
+            out_tp.var_o(1);
+            iter_type out_it(&out_tp, &graph);
+            if (!out_it.is_empty) {
+                for (uint64_t p = out_it.leap(0); p != 0; p = out_it.leap(0, p + 1)) {
+                    triple_pattern tp = out_tp.bind(0, p);
+                    iter_type it(&tp, &graph);
+                    np.out.push_back({p, it.is_empty ? 0 : util::get_size_interval(it)});
+                }
+            }
+            in_tp.var_s(1);
+            in_tp.var_p(0);
+            in_tp.const_o(v);
+            iter_type in_it(&in_tp, &graph);
+            if (!in_it.is_empty) {
+                for (uint64_t p = in_it.leap(0); p != 0; p = in_it.leap(0, p + 1)) {
+                    np.in.push_back(p);
+                }
+            }
+            return np;
+        }
+
+        static void write_vector(const std::vector<size_type> &vec, std::ostream &out, size_type &written_bytes) {
+            size_type n = vec.size();
+            written_bytes += sdsl::write_member(n, out);
+            for (const auto x : vec) written_bytes += sdsl::write_member(x, out);
+        }
+
+        static void read_vector(std::vector<size_type> &vec, std::istream &in) {
+            size_type n;
+            sdsl::read_member(n, in);
+            vec.resize(n);
+            for (auto &x : vec) sdsl::read_member(x, in);
+        }
+
+        static void write_pairs(const pair_map_type &m, std::ostream &out, size_type &written_bytes) {
+            size_type n = m.size();
+            written_bytes += sdsl::write_member(n, out);
+            for (const auto &e : m) {
+                written_bytes += sdsl::write_member(e.first.first, out);
+                written_bytes += sdsl::write_member(e.first.second, out);
+                written_bytes += sdsl::write_member(e.second, out);
+            }
+        }
+
+        static void read_pairs(pair_map_type &m, std::istream &in) {
+            size_type n;
+            sdsl::read_member(n, in);
+            m.clear();
+            for (size_type i = 0; i < n; ++i) {
+                pair_type key;
+                size_type count;
+                sdsl::read_member(key.first, in);
+                sdsl::read_member(key.second, in);
+                sdsl::read_member(count, in);
+                m.emplace_hint(m.end(), key, count);
+            }
+        }
+
+    public:
+        stats_catalog() = default;
+
+        //! Builds the statistics of the triples in D
+        stats_catalog(const vector<spo_triple> &D) {
+            // (node, predicate, triples) of the outgoing edges, and (node, predicate) of the incoming ones
+            std::vector<std::pair<pair_type, size_type>> out;
+            std::vector<pair_type> in;
+            {
+                std::vector<pair_type> sp;
+                sp.reserve(D.size());
+                in.reserve(D.size());
+                for (const auto &t : D) {
+                    sp.push_back({std::get<0>(t), std::get<1>(t)});
+                    in.push_back({std::get<2>(t), std::get<1>(t)});
+                }
+                std::sort(sp.begin(), sp.end());
+                for (const auto &e : sp) {
+                    if (!out.empty() && out.back().first == e) ++out.back().second;
+                    else out.push_back({e, 1});
+                }
+            }
+            std::sort(in.begin(), in.end());
+            in.erase(std::unique(in.begin(), in.end()), in.end());
+
+            // Merges both lists by node
+            size_type i = 0, j = 0;
+            while (i < out.size() || j < in.size()) {
+                uint64_t v = (j == in.size() || (i < out.size() && out[i].first.first < in[j].first))
+                             ? out[i].first.first : in[j].first;
+                node_profile np;
+                for (; i < out.size() && out[i].first.first == v; ++i) {
+                    np.out.push_back({out[i].first.second, out[i].second});
+                }
+                for (; j < in.size() && in[j].first == v; ++j) {
+                    np.in.push_back(in[j].second);
+                }
+                add(np, 1);
+            }
+        }
+
+        //! Copy constructor
+        stats_catalog(const stats_catalog &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        stats_catalog(stats_catalog &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        stats_catalog &operator=(const stats_catalog &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        stats_catalog &operator=(stats_catalog &&o) {
+            if (this != &o) {
+                m_n_triples = o.m_n_triples;
+                m_triples = std::move(o.m_triples);
+                m_subjects = std::move(o.m_subjects);
+                m_objects = std::move(o.m_objects);
+                m_star = std::move(o.m_star);
+                m_path = std::move(o.m_path);
+            }
+            return *this;
+        }
+
+        void swap(stats_catalog &o) {
+            std::swap(m_n_triples, o.m_n_triples);
+            std::swap(m_triples, o.m_triples);
+            std::swap(m_subjects, o.m_subjects);
+            std::swap(m_objects, o.m_objects);
+            std::swap(m_star, o.m_star);
+            std::swap(m_path, o.m_path);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_n_triples, out, child, "n_triples");
+            write_vector(m_triples, out, written_bytes);
+            write_vector(m_subjects, out, written_bytes);
+            write_vector(m_objects, out, written_bytes);
+            write_pairs(m_star, out, written_bytes);
+            write_pairs(m_path, out, written_bytes);
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        //! Loads the data structure from the given istream.
+        void load(std::istream &in) {
+            sdsl::read_member(m_n_triples, in);
+            read_vector(m_triples, in);
+            read_vector(m_subjects, in);
+            read_vector(m_objects, in);
+            read_pairs(m_star, in);
+            read_pairs(m_path, in);
+        }
+
+        //! File of the statistics of an index
+        static std::string file_of(const std::string &index) {
+            return index + ".stats";
+        }
+
+        //! Whether index has statistics
+        static bool exists(const std::string &index) {
+            return access(file_of(index).c_str(), F_OK) == 0;
+        }
+
+        //! Subjects and objects connected to v, v included
+        template <class ring_t>
+        static std::vector<uint64_t> neighbours(ring_t &graph, const uint64_t v) {
+            typedef ltj_iterator<ring_t, uint8_t, uint64_t> iter_type;
+            std::vector<uint64_t> res = {v};
+            triple_pattern out_tp, in_tp;
+            out_tp.const_s(v);
+            out_tp.var_p(0);
+            out_tp.var_o(1);
+            iter_type out_it(&out_tp, &graph);
+            if (!out_it.is_empty) {
+                for (uint64_t o = out_it.leap(1); o != 0; o = out_it.leap(1, o + 1)) res.push_back(o);
+            }
+            in_tp.var_s(1);
+            in_tp.var_p(0);
+            in_tp.const_o(v);
+            iter_type in_it(&in_tp, &graph);
+            if (!in_it.is_empty) {
+                for (uint64_t s = in_it.leap(1); s != 0; s = in_it.leap(1, s + 1)) res.push_back(s);
+            }
+            return res;
+        }
+
+        /**
+         * @brief Runs update over graph and updates the statistics
+         *
+         * @param nodes Every subject and object of the triples inserted or removed by update
+         */
+        template <class ring_t, class update_t>
+        void update(ring_t &graph, std::vector<uint64_t> nodes, update_t update) {
+            std::sort(nodes.begin(), nodes.end());
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+            for (const auto v : nodes) add(profile(graph, v), -1);
+            update();
+            for (const auto v : nodes) add(profile(graph, v), 1);
+        }
+
+        template <class ring_t>
+        void insert(ring_t &graph, const spo_triple &t) {
+            update(graph, {std::get<0>(t), std::get<2>(t)}, [&]() { graph.insert(t); });
+        }
+
+        template <class ring_t>
+        void remove_edge(ring_t &graph, const spo_triple &t) {
+            update(graph, {std::get<0>(t), std::get<2>(t)}, [&]() { graph.remove_edge(t); });
+        }
+
+        template <class ring_t>
+        void remove_node(ring_t &graph, const uint64_t v) {
+            update(graph, neighbours(graph, v), [&]() { graph.remove_node(v); });
+        }
+
+        inline size_type n_triples() const {
+            return m_n_triples;
+        }
+
+        //! Largest predicate with statistics
+        inline size_type max_p() const {
+            return m_triples.empty() ? 0 : m_triples.size() - 1;
+        }
+
+        inline size_type triples(const uint64_t p) const {
+            return p < m_triples.size() ? m_triples[p] : 0;
+        }
+
+        inline size_type subjects(const uint64_t p) const {
+            return p < m_subjects.size() ? m_subjects[p] : 0;
+        }
+
+        inline size_type objects(const uint64_t p) const {
+            return p < m_objects.size() ? m_objects[p] : 0;
+        }
+
+        //! Average triples of p per subject
+        inline double out_degree(const uint64_t p) const {
+            return subjects(p) == 0 ? 0 : (double) triples(p) / subjects(p);
+        }
+
+        //! Average triples of p per object
+        inline double in_degree(const uint64_t p) const {
+            return objects(p) == 0 ? 0 : (double) triples(p) / objects(p);
+        }
+
+        //! Nodes that are subject of p1 and of p2
+        inline size_type star(const uint64_t p1, const uint64_t p2) const {
+            if (p1 == p2) return subjects(p1);
+            return get_pair(m_star, {std::min(p1, p2), std::max(p1, p2)});
+        }
+
+        //! Nodes that are object of p1 and subject of p2
+        inline size_type path(const uint64_t p1, const uint64_t p2) const {
+            return get_pair(m_path, {p1, p2});
+        }
+    };
+
+    /**
+     * @brief Loads the statistics of an index, if they exist and describe a ring
+     * with its number of triples
+     */
+    template <class ring_t>
+    bool load_stats(stats_catalog &stats, ring_t &graph, const std::string &index) {
+        if (!stats_catalog::exists(index)) return false;
+        sdsl::load_from_file(stats, stats_catalog::file_of(index));
+        return stats.n_triples() == graph.n_triples();
+    }
+}
+
+#endif
@@ -32,6 +32,38 @@ namespace ring {
         bool is_variable;
     };
 
+    //! FILTER of a variable: ?var op constant, or ?var op ?other
+    struct filter_pattern {
+        enum op_type {equal, not_equal, less, less_equal, greater, greater_equal};
+
+        uint64_t var;
+        op_type op;
+        term_pattern term; //Constant or variable
+
+        //! True if a op b
+        static bool holds(const op_type op, const uint64_t a, const uint64_t b) {
+            switch (op) {
+                case equal: return a == b;
+                case not_equal: return a != b;
+                case less: return a < b;
+                case less_equal: return a <= b;
+                case greater: return a > b;
+                default: return a >= b;
+            }
+        }
+
+        //! Operator of b op' a, equivalent to a op b
+        static op_type mirror(const op_type op) {
+            switch (op) {
+                case less: return greater;
+                case less_equal: return greater_equal;
+                case greater: return less;
+                case greater_equal: return less_equal;
+                default: return op;
+            }
+        }
+    };
+
     struct triple_pattern {
         term_pattern term_s;
         term_pattern term_p;
@@ -79,6 +111,15 @@ namespace ring {
             return term_o.is_variable;
         }
 
+        //! Copy of the pattern with the variable var replaced by the constant c
+        triple_pattern bind(uint64_t var, uint64_t c) const {
+            triple_pattern t = *this;
+            if(s_is_variable() && term_s.value == var) t.const_s(c);
+            if(p_is_variable() && term_p.value == var) t.const_p(c);
+            if(o_is_variable() && term_o.value == var) t.const_o(c);
+            return t;
+        }
+
 
         void print(std::unordered_map<uint8_t, std::string> &ht) const {
             if(s_is_variable()){
@@ -0,0 +1,589 @@
+/*
+ * update_log.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_UPDATE_LOG_HPP
+#define RING_UPDATE_LOG_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "configuration.hpp"
+#include <chrono>
+#include <iostream>
+#include "chunk_store.hpp"
+#include "stats_catalog.hpp"
+#include "dict_map.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Append-only log of the updates applied to a dynamic ring (and its
+     * mappings) since its last checkpoint. Updates are buffered and written
+     * with a single fsync per group (group commit), so making them durable
+     * costs a sequential append instead of storing the whole index.
+     *
+     * Every record is framed as [length][checksum][payload], so a torn tail
+     * left by a crash is detected and dropped when the log is recovered.
+     *
+     * A checkpoint writes the files of the index to <file>.tmp (only the new
+     * chunks if the index is paged, see chunk_store), then appends
+     * a checkpoint record (the commit point), renames the temporary files
+     * and truncates the log. Recovery redoes the renames of a committed
+     * checkpoint and discards the temporary files of an uncommitted one.
+     */
+    class update_log {
+
+    public:
+        typedef uint64_t size_type;
+
+        enum op_type : uint8_t {
+            insert_op = 1,
+            delete_edge_op = 2,
+            delete_node_op = 3,
+            checkpoint_op = 4
+        };
+
+        //! An update. Mapped updates keep the terms, and unmapped ones the IDs
+        struct record {
+            op_type op;
+            spo_triple triple;
+            std::string terms[3];
+
+            bool mapped() const {
+                return !terms[0].empty();
+            }
+        };
+
+    private:
+        std::string m_file;
+        std::vector<std::string> m_files; // files written by a checkpoint
+        FILE *m_out = nullptr;
+        std::string m_buffer;
+        size_type m_buffered = 0;
+        size_type m_group;
+        size_type m_size = 0; // records since the last checkpoint
+        size_type m_checkpoint_interval;
+
+        //! FNV-1a
+        static uint32_t checksum(const char *data, size_type n) {
+            uint32_t h = 2166136261u;
+            for (size_type i = 0; i < n; ++i) {
+                h = (h ^ (uint8_t) data[i]) * 16777619u;
+            }
+            return h;
+        }
+
+        template <class T>
+        static void put(std::string &out, const T &value) {
+            out.append((const char *) &value, sizeof(T));
+        }
+
+        template <class T>
+        static bool get(const std::string &in, size_type &pos, T &value) {
+            if (pos + sizeof(T) > in.size()) return false;
+            std::copy(in.begin() + pos, in.begin() + pos + sizeof(T), (char *) &value);
+            pos += sizeof(T);
+            return true;
+        }
+
+        static void encode(const record &r, std::string &out) {
+            std::string payload;
+            put(payload, (uint8_t) r.op);
+            put(payload, (uint64_t) std::get<0>(r.triple));
+            put(payload, (uint64_t) std::get<1>(r.triple));
+            put(payload, (uint64_t) std::get<2>(r.triple));
+            for (const std::string &t : r.terms) {
+                put(payload, (uint32_t) t.size());
+                payload += t;
+            }
+            put(out, (uint32_t) payload.size());
+            put(out, checksum(payload.data(), payload.size()));
+            out += payload;
+        }
+
+        //! Decodes the record at pos; false if it is torn or corrupted
+        static bool decode(const std::string &in, size_type &pos, record &r) {
+            uint32_t length, sum;
+            size_type p = pos;
+            if (!get(in, p, length) || !get(in, p, sum) || p + length > in.size()) return false;
+            if (checksum(in.data() + p, length) != sum) return false;
+            std::string payload = in.substr(p, length);
+            size_type q = 0;
+            uint8_t op;
+            uint64_t s, pr, o;
+            if (!get(payload, q, op) || !get(payload, q, s) || !get(payload, q, pr) || !get(payload, q, o)) return false;
+            r.op = (op_type) op;
+            r.triple = spo_triple(s, pr, o);
+            for (std::string &t : r.terms) {
+                uint32_t n;
+                if (!get(payload, q, n) || q + n > payload.size()) return false;
+                t = payload.substr(q, n);
+                q += n;
+            }
+            pos = p + length;
+            return true;
+        }
+
+        static bool exists(const std::string &file) {
+            return access(file.c_str(), F_OK) == 0;
+        }
+
+        static void sync_file(const std::string &file) {
+            int fd = open(file.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            fsync(fd);
+            close(fd);
+        }
+
+        static void sync_dir(const std::string &file) {
+            auto p = file.find_last_of('/');
+            sync_file(p == std::string::npos ? "." : file.substr(0, p + 1));
+        }
+
+        void open_log(const char *mode) {
+            if (m_out) fclose(m_out);
+            m_out = fopen(m_file.c_str(), mode);
+            if (!m_out) throw std::runtime_error("Cannot open the log " + m_file);
+        }
+
+    public:
+        /**
+         * @param file The log
+         * @param files Files of the index stored by a checkpoint (ring and mappings)
+         * @param group_size Updates written by each group commit
+         * @param checkpoint_interval Updates in the log before a checkpoint is due
+         */
+        update_log(const std::string &file, const std::vector<std::string> &files,
+                   size_type group_size = 64, size_type checkpoint_interval = 1000000)
+                : m_file(file), m_files(files), m_group(group_size), m_checkpoint_interval(checkpoint_interval) {}
+
+        update_log(const update_log &) = delete;
+
+        update_log &operator=(const update_log &) = delete;
+
+        ~update_log() {
+            if (m_out) {
+                commit();
+                fclose(m_out);
+            }
+        }
+
+        static record insert(const spo_triple &t) {
+            return {insert_op, t, {}};
+        }
+
+        static record insert(const std::string &s, const std::string &p, const std::string &o) {
+            return {insert_op, spo_triple(0, 0, 0), {s, p, o}};
+        }
+
+        static record delete_edge(const spo_triple &t) {
+            return {delete_edge_op, t, {}};
+        }
+
+        static record delete_edge(const std::string &s, const std::string &p, const std::string &o) {
+            return {delete_edge_op, spo_triple(0, 0, 0), {s, p, o}};
+        }
+
+        static record delete_node(uint64_t v) {
+            return {delete_node_op, spo_triple(v, 0, 0), {}};
+        }
+
+        static record delete_node(const std::string &v) {
+            return {delete_node_op, spo_triple(0, 0, 0), {v, "", ""}};
+        }
+
+        const std::vector<std::string> &files() const {
+            return m_files;
+        }
+
+        /**
+         * @brief Completes or discards an interrupted checkpoint and drops a torn
+         * tail. It must be called before appending.
+         *
+         * @return The updates to replay over the files of the index, in order
+         */
+        std::vector<record> recover() {
+            std::string content;
+            {
+                std::ifstream in(m_file, std::ios::binary);
+                content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            std::vector<record> records;
+            size_type pos = 0, last_checkpoint = -1ULL;
+            record r;
+            while (decode(content, pos, r)) {
+                if (r.op == checkpoint_op) {
+                    last_checkpoint = records.size();
+                }
+                records.push_back(r);
+            }
+
+            if (last_checkpoint != -1ULL) {
+                for (const std::string &f : m_files) {
+                    if (exists(f + ".tmp")) std::rename((f + ".tmp").c_str(), f.c_str());
+                }
+                sync_dir(m_file);
+                records.erase(records.begin(), records.begin() + last_checkpoint + 1);
+            } else {
+                for (const std::string &f : m_files) {
+                    if (exists(f + ".tmp")) std::remove((f + ".tmp").c_str());
+                }
+            }
+
+            if (last_checkpoint != -1ULL || pos < content.size()) {
+                // Rewrites the log with the valid records after the checkpoint
+                std::string tmp = m_file + ".tmp", valid;
+                for (const record &x : records) encode(x, valid);
+                FILE *f = fopen(tmp.c_str(), "wb");
+                if (!f) throw std::runtime_error("Cannot open the log " + tmp);
+                fwrite(valid.data(), 1, valid.size(), f);
+                fflush(f);
+                fsync(fileno(f));
+                fclose(f);
+                std::rename(tmp.c_str(), m_file.c_str());
+                sync_dir(m_file);
+            }
+            open_log("ab");
+            m_size = records.size();
+            return records;
+        }
+
+        //! Adds an update, already applied in memory. It is durable after the next commit.
+        //! Returns true if it completed a group, which was committed
+        bool append(const record &r) {
+            encode(r, m_buffer);
+            ++m_size;
+            if (++m_buffered >= m_group) {
+                commit();
+                return true;
+            }
+            return false;
+        }
+
+        //! Writes the buffered updates with a single fsync
+        void commit() {
+            if (m_buffer.empty()) return;
+            fwrite(m_buffer.data(), 1, m_buffer.size(), m_out);
+            fflush(m_out);
+            fsync(fileno(m_out));
+            m_buffer.clear();
+            m_buffered = 0;
+        }
+
+        //! Number of updates since the last checkpoint
+        size_type size() const {
+            return m_size;
+        }
+
+        bool checkpoint_due() const {
+            return m_size >= m_checkpoint_interval;
+        }
+
+        /**
+         * @brief Stores the index and empties the log
+         *
+         * @param write Called as write(i, file) to store the i-th file of the index into file
+         */
+        template <class write_t>
+        void checkpoint(write_t write) {
+            commit();
+            for (size_type i = 0; i < m_files.size(); ++i) {
+                write(i, m_files[i] + ".tmp");
+                sync_file(m_files[i] + ".tmp");
+            }
+            record r = {checkpoint_op, spo_triple(0, 0, 0), {}};
+            encode(r, m_buffer);
+            commit();
+            for (const std::string &f : m_files) {
+                std::rename((f + ".tmp").c_str(), f.c_str());
+            }
+            sync_dir(m_file);
+            open_log("wb");
+            fsync(fileno(m_out));
+            m_size = 0;
+        }
+    };
+
+    //! Applies an unmapped update to the ring, and to its statistics if given
+    template <class ring_t>
+    void apply_update(ring_t &graph, const update_log::record &r, stats_catalog *stats = nullptr) {
+        switch (r.op) {
+            case update_log::insert_op:
+                if (stats) stats->insert(graph, r.triple);
+                else graph.insert(r.triple);
+                break;
+            case update_log::delete_edge_op:
+                if (stats) stats->remove_edge(graph, r.triple);
+                else graph.remove_edge(r.triple);
+                break;
+            case update_log::delete_node_op:
+                if (stats) stats->remove_node(graph, std::get<0>(r.triple));
+                else graph.remove_node(std::get<0>(r.triple));
+                break;
+            default:
+                break;
+        }
+    }
+
+    //! Applies a mapped update to the ring and its mappings, as the update tools do
+    template <class ring_t, class map_t>
+    void apply_update(ring_t &graph, map_t &so_mapping, map_t &p_mapping, const update_log::record &r,
+                      stats_catalog *stats = nullptr) {
+        switch (r.op) {
+            case update_log::insert_op: {
+                spo_triple t(so_mapping.get_or_insert(r.terms[0]), p_mapping.get_or_insert(r.terms[1]),
+                             so_mapping.get_or_insert(r.terms[2]));
+                if (stats) stats->insert(graph, t);
+                else graph.insert(t);
+                break;
+            }
+            case update_log::delete_edge_op: {
+                spo_triple t(so_mapping.locate(r.terms[0]), p_mapping.locate(r.terms[1]), so_mapping.locate(r.terms[2]));
+                spo_valid_triple valid;
+                auto remove = [&]() { valid = graph.remove_edge_and_check(t); };
+                if (stats) stats->update(graph, {std::get<0>(t), std::get<2>(t)}, remove);
+                else remove();
+                if (!std::get<0>(valid)) so_mapping.eliminate(std::get<0>(t));
+                if (!std::get<1>(valid)) p_mapping.eliminate(std::get<1>(t));
+                if (!std::get<2>(valid)) so_mapping.eliminate(std::get<2>(t));
+                break;
+            }
+            case update_log::delete_node_op: {
+                std::vector<uint64_t> so_removed, p_removed;
+                uint64_t v = so_mapping.eliminate(r.terms[0]);
+                auto remove = [&]() { graph.remove_node_with_check(v, so_removed, p_removed); };
+                if (stats) stats->update(graph, stats_catalog::neighbours(graph, v), remove);
+                else remove();
+                so_mapping.eliminate_batch(so_removed);
+                p_mapping.eliminate_batch(p_removed);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    //! Stores the ring into file, paged if the index is paged
+    template <class ring_t>
+    void store_index(ring_t &graph, const std::string &index, const std::string &file) {
+        if (chunk_store::is_paged(index)) {
+            chunk_store(index).write_to(graph, file);
+        } else {
+            sdsl::store_to_file(graph, file);
+        }
+    }
+
+    /**
+     * @brief Loads the last checkpoint of the ring and replays the log over it
+     *
+     * @param stats (Optional) Statistics of the ring, kept in the last file of the log
+     * @return Number of updates replayed
+     */
+    template <class ring_t>
+    uint64_t recover(update_log &log, ring_t &graph, stats_catalog *stats = nullptr) {
+        auto records = log.recover();
+        load_index(graph, log.files()[0]);
+        if (stats) sdsl::load_from_file(*stats, log.files().back());
+        for (const auto &r : records) {
+            apply_update(graph, r, stats);
+        }
+        return records.size();
+    }
+
+    //! Mapped version; the files of the log are the ring, the SO mapping and the P mapping
+    template <class ring_t, class map_t>
+    uint64_t recover(update_log &log, ring_t &graph, map_t &so_mapping, map_t &p_mapping,
+                     stats_catalog *stats = nullptr) {
+        auto records = log.recover();
+        load_index(graph, log.files()[0]);
+        std::ifstream so_in(log.files()[1], std::ios::binary);
+        so_mapping.load(so_in);
+        std::ifstream p_in(log.files()[2], std::ios::binary);
+        p_mapping.load(p_in);
+        if (stats) sdsl::load_from_file(*stats, log.files().back());
+        for (const auto &r : records) {
+            apply_update(graph, so_mapping, p_mapping, r, stats);
+        }
+        return records.size();
+    }
+
+    template <class ring_t>
+    void checkpoint(update_log &log, ring_t &graph, stats_catalog *stats = nullptr) {
+        log.checkpoint([&](uint64_t i, const std::string &file) {
+            if (i == 0) store_index(graph, log.files()[0], file);
+            else sdsl::store_to_file(*stats, file);
+        });
+    }
+
+    template <class ring_t, class map_t>
+    void checkpoint(update_log &log, ring_t &graph, map_t &so_mapping, map_t &p_mapping,
+                    stats_catalog *stats = nullptr) {
+        log.checkpoint([&](uint64_t i, const std::string &file) {
+            if (i == 0) {
+                store_index(graph, log.files()[0], file);
+                return;
+            }
+            if (i == 3) {
+                sdsl::store_to_file(*stats, file);
+                return;
+            }
+            std::ofstream out(file, std::ios::binary | std::ios::trunc | std::ios::out);
+            (i == 1 ? so_mapping : p_mapping).serialize(out);
+        });
+    }
+
+    /**
+     * @brief Runs updates on an index loaded from its last checkpoint and log,
+     * as the update tools do with a log. Each update is applied and appended
+     * to the log, and a checkpoint is stored as soon as it is due, after the
+     * group commit that made it due. Prints the number of each update and the
+     * nanoseconds taken to apply it and to log it.
+     *
+     * @param log Log of the index, already recovered
+     * @param updates Updates to run, in order
+     * @param apply Called as apply(update) to apply an update
+     * @param store Called as store() to store a checkpoint
+     */
+    template <class apply_t, class store_t>
+    void run_logged_updates(update_log &log, const std::vector<update_log::record> &updates,
+                            apply_t apply, store_t store) {
+        using namespace std::chrono;
+        high_resolution_clock::time_point start, stop;
+        duration<double> time_span;
+        double total_time, log_time;
+        uint64_t nQ = 0;
+        for (const update_log::record &update : updates) {
+            start = high_resolution_clock::now();
+            apply(update);
+            stop = high_resolution_clock::now();
+            time_span = duration_cast<microseconds>(stop - start);
+            total_time = time_span.count();
+
+            start = high_resolution_clock::now();
+            bool committed = log.append(update);
+            stop = high_resolution_clock::now();
+            time_span = duration_cast<microseconds>(stop - start);
+            log_time = time_span.count();
+
+            std::cout << nQ << ";" << (unsigned long long)(total_time * 1000000000ULL);
+            std::cout << ";" << (unsigned long long)(log_time * 1000000000ULL) << std::endl;
+            nQ++;
+            if (committed && log.checkpoint_due()) {
+                store();
+                std::cout << "Checkpoint stored" << std::endl;
+            }
+        }
+        log.commit();
+        if (log.checkpoint_due()) {
+            store();
+            std::cout << "Checkpoint stored" << std::endl;
+        }
+    }
+
+    //! Files of the log of an index: the index, the mappings if given and the statistics if it has them
+    inline std::vector<std::string> logged_files(const std::string &file, const std::string &so_mapping_file = "",
+                                                 const std::string &p_mapping_file = "") {
+        std::vector<std::string> files = {file};
+        if (!so_mapping_file.empty()) {
+            files.push_back(so_mapping_file);
+            files.push_back(p_mapping_file);
+        }
+        if (stats_catalog::exists(file)) {
+            // The statistics of the index are checkpointed with it
+            files.push_back(stats_catalog::file_of(file));
+        }
+        return files;
+    }
+
+    //! Unmapped updates on the index in file, logged in log_file
+    template <class ring_t>
+    void logged_updates(const std::string &file, const std::string &log_file,
+                        const std::vector<update_log::record> &updates) {
+        ring_t graph;
+        stats_catalog stats, *ptr_stats = stats_catalog::exists(file) ? &stats : nullptr;
+        update_log log(log_file, logged_files(file));
+
+        std::cout << " Loading the index...";
+        fflush(stdout);
+        uint64_t replayed = recover(log, graph, ptr_stats);
+        std::cout << std::endl
+                  << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes, "
+                  << replayed << " updates replayed from the log" << std::endl;
+
+        run_logged_updates(log, updates,
+                           [&](const update_log::record &r) { apply_update(graph, r, ptr_stats); },
+                           [&]() { checkpoint(log, graph, ptr_stats); });
+    }
+
+    //! Mapped updates on the index in file and its mappings, logged in log_file
+    template <class ring_t, class map_t>
+    void mapped_logged_updates(const std::string &file, const std::string &so_mapping_file,
+                               const std::string &p_mapping_file, const std::string &log_file,
+                               const std::vector<update_log::record> &updates) {
+        ring_t graph;
+        map_t so_mapping, p_mapping;
+        stats_catalog stats, *ptr_stats = stats_catalog::exists(file) ? &stats : nullptr;
+        update_log log(log_file, logged_files(file, so_mapping_file, p_mapping_file));
+
+        std::cout << " Loading the index and the mappings...";
+        fflush(stdout);
+        uint64_t replayed = recover(log, graph, so_mapping, p_mapping, ptr_stats);
+        std::cout << std::endl
+                  << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes, "
+                  << replayed << " updates replayed from the log" << std::endl;
+
+        run_logged_updates(log, updates,
+                           [&](const update_log::record &r) { apply_update(graph, so_mapping, p_mapping, r, ptr_stats); },
+                           [&]() { checkpoint(log, graph, so_mapping, p_mapping, ptr_stats); });
+    }
+
+    /**
+     * @brief Logged updates on an index of the given type, mapped if the
+     * mappings are given
+     *
+     * @return false if the type of index does not support logging
+     */
+    inline bool logged_updates(const std::string &type, const std::string &file, const std::string &so_mapping_file,
+                               const std::string &p_mapping_file, const std::string &log_file,
+                               const std::vector<update_log::record> &updates) {
+        const bool mapped = !so_mapping_file.empty();
+        if (type == "ring-dyn-basic") {
+            if (mapped) mapped_logged_updates<ring_dyn, basic_map>(file, so_mapping_file, p_mapping_file, log_file, updates);
+            else logged_updates<ring_dyn>(file, log_file, updates);
+        } else if (type == "ring-dyn") {
+            if (mapped) mapped_logged_updates<medium_ring_dyn, basic_map>(file, so_mapping_file, p_mapping_file, log_file, updates);
+            else logged_updates<medium_ring_dyn>(file, log_file, updates);
+        } else if (type == "ring-dyn-read") {
+            if (mapped) mapped_logged_updates<read_ring_dyn, basic_map>(file, so_mapping_file, p_mapping_file, log_file, updates);
+            else logged_updates<read_ring_dyn>(file, log_file, updates);
+        } else if (type == "ring-dyn-update") {
+            if (mapped) mapped_logged_updates<update_ring_dyn, basic_map>(file, so_mapping_file, p_mapping_file, log_file, updates);
+            else logged_updates<update_ring_dyn>(file, log_file, updates);
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -23,6 +23,9 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <queue>
 #include "ring.hpp"
 
 
@@ -50,6 +53,59 @@ namespace ring {
             }
             return 0;
         }
+
+        /**
+         * @brief Bounded heap with the first k tuples ordered by the value of var.
+         * The tuples without var have the value 0: they go first in ascending
+         * order and last in descending order. Its top is the worst of the k tuples.
+         */
+        template<class tuple_t, class var_t>
+        class top_k_heap {
+            typedef std::pair<uint64_t, tuple_t> entry_type;
+
+            struct worse_type {
+                bool descending;
+                bool operator()(const entry_type &a, const entry_type &b) const {
+                    return descending ? a.first > b.first : a.first < b.first;
+                }
+            };
+
+            std::priority_queue<entry_type, std::vector<entry_type>, worse_type> m_heap;
+            var_t m_var;
+            uint64_t m_k;
+            bool m_descending;
+
+        public:
+            top_k_heap(const var_t var, const uint64_t k, const bool descending)
+                    : m_heap(worse_type{descending}), m_var(var), m_k(k), m_descending(descending) {}
+
+            //! Keeps t if it is among the best k tuples so far
+            void push(const tuple_t &t) {
+                uint64_t c = 0;
+                for (const auto &e : t) {
+                    if (e.first == m_var) {
+                        c = e.second;
+                        break;
+                    }
+                }
+                if (m_heap.size() < m_k) {
+                    m_heap.push({c, t});
+                } else if (m_k > 0 && (m_descending ? c > m_heap.top().first : c < m_heap.top().first)) {
+                    m_heap.pop();
+                    m_heap.push({c, t});
+                }
+            }
+
+            //! Appends the tuples to res in order and empties the heap
+            void pop_all(std::vector<tuple_t> &res) {
+                uint64_t n = res.size();
+                res.resize(n + m_heap.size());
+                for (uint64_t i = res.size(); i > n; --i) {
+                    res[i - 1] = m_heap.top().second;
+                    m_heap.pop();
+                }
+            }
+        };
     }
 
 }
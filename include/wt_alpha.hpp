@@ -0,0 +1,383 @@
+/*
+ * wt_alpha.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_WT_ALPHA_HPP
+#define RING_WT_ALPHA_HPP
+
+#include "configuration.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Huffman-shaped wavelet tree with an alphabetic (order-preserving) code.
+     * Each node splits its symbol range where the frequencies are halved, so
+     * a symbol of frequency f sits at depth at most log(n/f) + 2. Keeping the
+     * leaves in symbol order is what allows range_next_value and
+     * range_minimum_query, which a canonical Huffman code would break.
+     * It exposes the same interface as sdsl::wm_int.
+     */
+    template <class t_bitvector = bit_vector,
+            class t_rank = typename t_bitvector::rank_1_type,
+            class t_select = typename t_bitvector::select_1_type,
+            class t_select_zero = typename t_bitvector::select_0_type>
+    class wt_alpha {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+
+    private:
+        static const uint64_t no_child = -1ULL;
+
+        struct node_type {
+            uint64_t lo;       // smallest symbol of the node
+            uint64_t hi;       // largest symbol of the node
+            uint64_t mid;      // symbols <= mid go to the left child
+            uint64_t bv_off;   // first bit of the node in m_tree
+            uint64_t ones_off; // ones in m_tree before bv_off
+            uint64_t child[2];
+        };
+
+        size_type m_size = 0;
+        size_type m_sigma = 0;
+        std::vector<node_type> m_nodes; // m_nodes[0] is the root
+        t_bitvector m_tree;
+        t_rank m_tree_rank;
+        t_select m_tree_select1;
+        t_select_zero m_tree_select0;
+
+        void copy(const wt_alpha &o) {
+            m_size = o.m_size;
+            m_sigma = o.m_sigma;
+            m_nodes = o.m_nodes;
+            m_tree = o.m_tree;
+            m_tree_rank = o.m_tree_rank;
+            m_tree_rank.set_vector(&m_tree);
+            m_tree_select1 = o.m_tree_select1;
+            m_tree_select1.set_vector(&m_tree);
+            m_tree_select0 = o.m_tree_select0;
+            m_tree_select0.set_vector(&m_tree);
+        }
+
+        inline bool is_leaf(const node_type &v) const {
+            return v.lo == v.hi;
+        }
+
+        //! Number of ones in the first i bits of node v
+        inline uint64_t rank1(const node_type &v, uint64_t i) const {
+            return m_tree_rank(v.bv_off + i) - v.ones_off;
+        }
+
+        //! Maps position i of node v to its position in the child selected by bit
+        inline uint64_t map_to_child(const node_type &v, uint64_t i, bool bit) const {
+            uint64_t ones = rank1(v, i);
+            return bit ? ones : i - ones;
+        }
+
+        uint64_t build_nodes(uint64_t lo, uint64_t hi, const std::vector<uint64_t> &acc) {
+            uint64_t id = m_nodes.size();
+            m_nodes.push_back({lo, hi, hi, 0, 0, {no_child, no_child}});
+            if (lo == hi) return id;
+            uint64_t mid;
+            uint64_t total = acc[hi + 1] - acc[lo];
+            if (total == 0) {
+                mid = lo + (hi - lo) / 2;
+            } else {
+                // mid minimizes |acc[mid + 1] - target| with lo <= mid < hi
+                uint64_t target = acc[lo] + total / 2;
+                auto it = std::lower_bound(acc.begin() + lo + 1, acc.begin() + hi + 1, target);
+                uint64_t k = it - acc.begin();
+                mid = std::min(k, hi) - 1;
+                if (k <= hi && mid > lo && target - acc[mid] < acc[mid + 1] - target) {
+                    --mid;
+                }
+            }
+            m_nodes[id].mid = mid;
+            uint64_t left = build_nodes(lo, mid, acc);
+            uint64_t right = build_nodes(mid + 1, hi, acc);
+            m_nodes[id].child[0] = left;
+            m_nodes[id].child[1] = right;
+            return id;
+        }
+
+        bool next_value(uint64_t id, uint64_t x, uint64_t b, uint64_t e, uint64_t &res) const {
+            const node_type &v = m_nodes[id];
+            if (b >= e || v.hi < x) return false;
+            if (is_leaf(v)) {
+                res = v.lo;
+                return true;
+            }
+            uint64_t ones_b = rank1(v, b), ones_e = rank1(v, e);
+            if (x <= v.mid && next_value(v.child[0], x, b - ones_b, e - ones_e, res)) {
+                return true;
+            }
+            return next_value(v.child[1], x, ones_b, ones_e, res);
+        }
+
+        void values(uint64_t id, uint64_t b, uint64_t e, std::vector<uint64_t> &res) const {
+            if (b >= e) return;
+            const node_type &v = m_nodes[id];
+            if (is_leaf(v)) {
+                res.push_back(v.lo);
+                return;
+            }
+            uint64_t ones_b = rank1(v, b), ones_e = rank1(v, e);
+            values(v.child[0], b - ones_b, e - ones_e, res);
+            values(v.child[1], ones_b, ones_e, res);
+        }
+
+        //! Position in node id of the pos-th (from 0) occurrence of c in its subtree.
+        //! The recursion goes as deep as the tree, which has no fixed bound.
+        uint64_t select_from(uint64_t id, uint64_t pos, uint64_t c) const {
+            const node_type &v = m_nodes[id];
+            if (is_leaf(v)) return pos;
+            if (c > v.mid) {
+                pos = select_from(v.child[1], pos, c);
+                return m_tree_select1(v.ones_off + pos + 1) - v.bv_off;
+            }
+            pos = select_from(v.child[0], pos, c);
+            return m_tree_select0(v.bv_off - v.ones_off + pos + 1) - v.bv_off;
+        }
+
+    public:
+        wt_alpha() = default;
+
+        wt_alpha(const int_vector<> &L) {
+            m_size = L.size();
+            m_sigma = 0;
+            for (uint64_t i = 0; i < m_size; ++i) {
+                m_sigma = std::max<uint64_t>(m_sigma, L[i] + 1);
+            }
+            if (m_size == 0) return;
+            std::vector<uint64_t> acc(m_sigma + 1, 0);
+            for (uint64_t i = 0; i < m_size; ++i) {
+                ++acc[L[i] + 1];
+            }
+            for (uint64_t c = 0; c < m_sigma; ++c) {
+                acc[c + 1] += acc[c];
+            }
+            build_nodes(0, m_sigma - 1, acc);
+
+            // Nodes are filled breadth first; the elements of every node are kept
+            // contiguous in seq, in the order they appear in the node.
+            uint64_t total_bits = 0;
+            for (auto &v : m_nodes) {
+                if (!is_leaf(v)) total_bits += acc[v.hi + 1] - acc[v.lo];
+            }
+            bit_vector tree(total_bits, 0);
+            std::vector<uint64_t> seq(L.begin(), L.end()), tmp;
+            std::vector<std::pair<uint64_t, uint64_t>> level = {{0, 0}}, next; // node and first element in seq
+            uint64_t off = 0, ones = 0;
+            while (!level.empty()) {
+                next.clear();
+                for (auto &p : level) {
+                    node_type &v = m_nodes[p.first];
+                    if (is_leaf(v)) continue;
+                    uint64_t len = acc[v.hi + 1] - acc[v.lo];
+                    v.bv_off = off;
+                    v.ones_off = ones;
+                    tmp.clear();
+                    uint64_t n_left = 0;
+                    for (uint64_t i = p.second; i < p.second + len; ++i) {
+                        if (seq[i] > v.mid) {
+                            tree[off + i - p.second] = 1;
+                            tmp.push_back(seq[i]);
+                        } else {
+                            seq[p.second + n_left++] = seq[i];
+                        }
+                    }
+                    std::copy(tmp.begin(), tmp.end(), seq.begin() + p.second + n_left);
+                    off += len;
+                    ones += tmp.size();
+                    next.emplace_back(v.child[0], p.second);
+                    next.emplace_back(v.child[1], p.second + n_left);
+                }
+                level.swap(next);
+            }
+            m_tree = t_bitvector(tree);
+            util::init_support(m_tree_rank, &m_tree);
+            util::init_support(m_tree_select1, &m_tree);
+            util::init_support(m_tree_select0, &m_tree);
+        }
+
+        //! Copy constructor
+        wt_alpha(const wt_alpha &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        wt_alpha(wt_alpha &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        wt_alpha &operator=(const wt_alpha &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        wt_alpha &operator=(wt_alpha &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_sigma = o.m_sigma;
+                m_nodes = std::move(o.m_nodes);
+                m_tree = std::move(o.m_tree);
+                m_tree_rank = std::move(o.m_tree_rank);
+                m_tree_rank.set_vector(&m_tree);
+                m_tree_select1 = std::move(o.m_tree_select1);
+                m_tree_select1.set_vector(&m_tree);
+                m_tree_select0 = std::move(o.m_tree_select0);
+                m_tree_select0.set_vector(&m_tree);
+            }
+            return *this;
+        }
+
+        void swap(wt_alpha &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_sigma, o.m_sigma);
+            m_nodes.swap(o.m_nodes);
+            std::swap(m_tree, o.m_tree);
+            sdsl::util::swap_support(m_tree_rank, o.m_tree_rank, &m_tree, &o.m_tree);
+            sdsl::util::swap_support(m_tree_select1, o.m_tree_select1, &m_tree, &o.m_tree);
+            sdsl::util::swap_support(m_tree_select0, o.m_tree_select0, &m_tree, &o.m_tree);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline size_type sigma() const {
+            return m_sigma;
+        }
+
+        inline value_type operator[](size_type i) const {
+            return inverse_select(i).second;
+        }
+
+        //! Number of occurrences of c in [0, i)
+        size_type rank(size_type i, value_type c) const {
+            if (c >= m_sigma || m_size == 0) return 0;
+            uint64_t id = 0;
+            while (!is_leaf(m_nodes[id])) {
+                const node_type &v = m_nodes[id];
+                bool bit = c > v.mid;
+                i = map_to_child(v, i, bit);
+                id = v.child[bit];
+            }
+            return i;
+        }
+
+        //! Returns {rank(i, L[i]), L[i]}
+        std::pair<size_type, value_type> inverse_select(size_type i) const {
+            uint64_t id = 0;
+            while (!is_leaf(m_nodes[id])) {
+                const node_type &v = m_nodes[id];
+                bool bit = m_tree[v.bv_off + i];
+                i = map_to_child(v, i, bit);
+                id = v.child[bit];
+            }
+            return {i, m_nodes[id].lo};
+        }
+
+        //! Position of the j-th (j >= 1) occurrence of c
+        size_type select(size_type j, value_type c) const {
+            return select_from(0, j - 1, c);
+        }
+
+        std::pair<size_type, size_type> select_next(size_type pos, value_type c, size_type n_elems) const {
+            uint64_t r = rank(pos, c);
+            if (r >= n_elems) return {0, 0};
+            return {select(r + 1, c), r};
+        }
+
+        //! Smallest value in L[l..r]
+        value_type range_minimum_query(size_type l, size_type r) const {
+            uint64_t b = l, e = r + 1, id = 0;
+            while (!is_leaf(m_nodes[id])) {
+                const node_type &v = m_nodes[id];
+                uint64_t ones_b = rank1(v, b), ones_e = rank1(v, e);
+                if (e - b > ones_e - ones_b) {
+                    b -= ones_b;
+                    e -= ones_e;
+                    id = v.child[0];
+                } else {
+                    b = ones_b;
+                    e = ones_e;
+                    id = v.child[1];
+                }
+            }
+            return m_nodes[id].lo;
+        }
+
+        //! Smallest value >= x in L[l..r], 0 if there is none
+        value_type range_next_value(value_type x, size_type l, size_type r) const {
+            uint64_t res = 0;
+            if (m_size == 0 || l > r) return 0;
+            return next_value(0, x, l, std::min(r + 1, m_size), res) ? res : 0;
+        }
+
+        //! Distinct values of L[l..r] in increasing order
+        std::vector<value_type> all_values_in_range(size_type l, size_type r) const {
+            std::vector<value_type> res;
+            if (m_size > 0) values(0, l, r + 1, res);
+            return res;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "wt_alpha");
+            size_type written_bytes = 0;
+            uint64_t n_nodes = m_nodes.size();
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_sigma, out, child, "sigma");
+            written_bytes += sdsl::write_member(n_nodes, out, child, "n_nodes");
+            out.write((const char *) m_nodes.data(), n_nodes * sizeof(node_type));
+            written_bytes += n_nodes * sizeof(node_type);
+            written_bytes += m_tree.serialize(out, child, "tree");
+            written_bytes += m_tree_rank.serialize(out, child, "tree_rank");
+            written_bytes += m_tree_select1.serialize(out, child, "tree_select_1");
+            written_bytes += m_tree_select0.serialize(out, child, "tree_select_0");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            uint64_t n_nodes;
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(m_sigma, in);
+            sdsl::read_member(n_nodes, in);
+            m_nodes.resize(n_nodes);
+            in.read((char *) m_nodes.data(), n_nodes * sizeof(node_type));
+            m_tree.load(in);
+            m_tree_rank.load(in, &m_tree);
+            m_tree_select1.load(in, &m_tree);
+            m_tree_select0.load(in, &m_tree);
+        }
+    };
+
+    template <class t_bitvector, class t_rank, class t_select, class t_select_zero>
+    void construct_im(wt_alpha<t_bitvector, t_rank, t_select, t_select_zero> &wt, const int_vector<> &L) {
+        wt = wt_alpha<t_bitvector, t_rank, t_select, t_select_zero>(L);
+    }
+}
+
+#endif
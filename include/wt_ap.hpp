@@ -0,0 +1,314 @@
+/*
+ * wt_ap.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_WT_AP_HPP
+#define RING_WT_AP_HPP
+
+#include "configuration.hpp"
+#include "wt_alpha.hpp"
+
+namespace ring {
+
+    /**
+     * @brief Alphabet-partitioned sequence (Barbay et al.). Symbols are grouped in
+     * classes by frequency rank (class k holds ranks [2^k - 1, 2^(k+1) - 1)),
+     * the sequence of classes K is kept in an entropy-shaped wavelet tree and
+     * the occurrences of each class in a wavelet matrix over its 2^k local codes.
+     * Local codes follow symbol order, so range queries are answered class by
+     * class. It exposes the same interface as sdsl::wm_int.
+     *
+     * @tparam t_class_seq Sequence of classes of the text
+     * @tparam t_seq Sequence of local codes of one class
+     */
+    template <class t_class_seq = wt_alpha<>,
+            class t_seq = sdsl::wm_int<>>
+    class wt_ap {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+
+    private:
+        size_type m_size = 0;
+        size_type m_sigma = 0;
+        uint64_t m_classes = 0;
+        sdsl::wm_int<> m_map;      // class of each symbol, in symbol order (m_classes if absent)
+        t_class_seq m_K;           // class of each position of the text
+        std::vector<t_seq> m_seqs; // local codes of each class; empty for single-symbol classes
+
+        void copy(const wt_ap &o) {
+            m_size = o.m_size;
+            m_sigma = o.m_sigma;
+            m_classes = o.m_classes;
+            m_map = o.m_map;
+            m_K = o.m_K;
+            m_seqs = o.m_seqs;
+        }
+
+        inline bool single(uint64_t k) const {
+            return m_seqs[k].size() == 0;
+        }
+
+        //! Symbol of local code o in class k
+        inline value_type symbol(uint64_t k, uint64_t o) const {
+            return m_map.select(o + 1, k);
+        }
+
+        /**
+         * Smallest value >= x of class k in L[l..r]; false if there is none or
+         * if it cannot be smaller than bound (k must occur in L[l..r])
+         */
+        bool class_next_value(uint64_t k, value_type x, size_type l, size_type r,
+                              value_type bound, value_type &res) const {
+            uint64_t o_x = m_map.rank(x, k);
+            if (single(k)) {
+                if (o_x > 0) return false;
+                res = symbol(k, 0);
+                return res < bound;
+            }
+            if (bound != -1ULL) {
+                //Smallest symbol >= x of the class, wherever it occurs
+                if (o_x >= m_map.rank(m_sigma, k) || symbol(k, o_x) >= bound) return false;
+            }
+            uint64_t b = m_K.rank(l, k), e = m_K.rank(r + 1, k);
+            uint64_t o;
+            if (o_x == 0) {
+                o = m_seqs[k].range_minimum_query(b, e - 1);
+            } else {
+                o = m_seqs[k].range_next_value(o_x, b, e - 1);
+                if (o == 0) return false;
+            }
+            res = symbol(k, o);
+            return res < bound;
+        }
+
+    public:
+        wt_ap() = default;
+
+        wt_ap(const int_vector<> &L) {
+            m_size = L.size();
+            m_sigma = 0;
+            for (uint64_t i = 0; i < m_size; ++i) {
+                m_sigma = std::max<uint64_t>(m_sigma, L[i] + 1);
+            }
+            std::vector<uint64_t> freq(m_sigma, 0);
+            for (uint64_t i = 0; i < m_size; ++i) {
+                ++freq[L[i]];
+            }
+            std::vector<uint64_t> by_freq;
+            for (uint64_t c = 0; c < m_sigma; ++c) {
+                if (freq[c] > 0) by_freq.push_back(c);
+            }
+            std::stable_sort(by_freq.begin(), by_freq.end(), [&freq](uint64_t a, uint64_t b) {
+                return freq[a] > freq[b];
+            });
+            m_classes = by_freq.empty() ? 0 : sdsl::bits::hi(by_freq.size()) + 1;
+
+            int_vector<> cls(m_sigma, m_classes);
+            for (uint64_t r = 0; r < by_freq.size(); ++r) {
+                cls[by_freq[r]] = sdsl::bits::hi(r + 1);
+            }
+            // Local code of a symbol: number of smaller symbols in its class
+            std::vector<uint64_t> local(m_sigma, 0), class_sigma(m_classes + 1, 0), class_len(m_classes, 0);
+            for (uint64_t c = 0; c < m_sigma; ++c) {
+                local[c] = class_sigma[cls[c]]++;
+            }
+            int_vector<> K(m_size, 0);
+            for (uint64_t i = 0; i < m_size; ++i) {
+                K[i] = cls[L[i]];
+                ++class_len[K[i]];
+            }
+            std::vector<int_vector<>> codes(m_classes);
+            for (uint64_t k = 0; k < m_classes; ++k) {
+                if (class_sigma[k] > 1) codes[k] = int_vector<>(class_len[k], 0);
+                class_len[k] = 0;
+            }
+            for (uint64_t i = 0; i < m_size; ++i) {
+                uint64_t k = K[i];
+                if (class_sigma[k] > 1) codes[k][class_len[k]] = local[L[i]];
+                ++class_len[k];
+            }
+
+            construct_im(m_map, cls);
+            construct_im(m_K, K);
+            m_seqs.resize(m_classes);
+            for (uint64_t k = 0; k < m_classes; ++k) {
+                if (class_sigma[k] > 1) construct_im(m_seqs[k], codes[k]);
+            }
+        }
+
+        //! Copy constructor
+        wt_ap(const wt_ap &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        wt_ap(wt_ap &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        wt_ap &operator=(const wt_ap &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        wt_ap &operator=(wt_ap &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_sigma = o.m_sigma;
+                m_classes = o.m_classes;
+                m_map = std::move(o.m_map);
+                m_K = std::move(o.m_K);
+                m_seqs = std::move(o.m_seqs);
+            }
+            return *this;
+        }
+
+        void swap(wt_ap &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_sigma, o.m_sigma);
+            std::swap(m_classes, o.m_classes);
+            m_map.swap(o.m_map);
+            m_K.swap(o.m_K);
+            m_seqs.swap(o.m_seqs);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline size_type sigma() const {
+            return m_sigma;
+        }
+
+        inline value_type operator[](size_type i) const {
+            return inverse_select(i).second;
+        }
+
+        //! Number of occurrences of c in [0, i)
+        size_type rank(size_type i, value_type c) const {
+            if (c >= m_sigma) return 0;
+            auto p = m_map.inverse_select(c);
+            if (p.second == m_classes) return 0;
+            uint64_t i_k = m_K.rank(i, p.second);
+            return single(p.second) ? i_k : m_seqs[p.second].rank(i_k, p.first);
+        }
+
+        //! Returns {rank(i, L[i]), L[i]}
+        std::pair<size_type, value_type> inverse_select(size_type i) const {
+            auto p = m_K.inverse_select(i);
+            if (single(p.second)) {
+                return {p.first, symbol(p.second, 0)};
+            }
+            auto q = m_seqs[p.second].inverse_select(p.first);
+            return {q.first, symbol(p.second, q.second)};
+        }
+
+        //! Position of the j-th (j >= 1) occurrence of c
+        size_type select(size_type j, value_type c) const {
+            if (c >= m_sigma) return m_size;
+            auto p = m_map.inverse_select(c);
+            if (p.second == m_classes) return m_size;
+            uint64_t pos_k = single(p.second) ? j - 1 : m_seqs[p.second].select(j, p.first);
+            return m_K.select(pos_k + 1, p.second);
+        }
+
+        std::pair<size_type, size_type> select_next(size_type pos, value_type c, size_type n_elems) const {
+            uint64_t r = rank(pos, c);
+            if (r >= n_elems) return {0, 0};
+            return {select(r + 1, c), r};
+        }
+
+        //! Smallest value in L[l..r]
+        value_type range_minimum_query(size_type l, size_type r) const {
+            return range_next_value(0, l, r);
+        }
+
+        //! Smallest value >= x in L[l..r], 0 if there is none
+        value_type range_next_value(value_type x, size_type l, size_type r) const {
+            if (m_size == 0 || l > r || x >= m_sigma) return 0;
+            value_type best = -1ULL, v;
+            //Classes of L[l..r] in increasing order, without materialising them
+            uint64_t k = m_K.range_minimum_query(l, r);
+            while (true) {
+                if (class_next_value(k, x, l, r, best, v)) best = v;
+                if (best == x || k + 1 >= m_classes) break; //No class can improve best
+                k = m_K.range_next_value(k + 1, l, r);
+                if (k == 0) break;
+            }
+            return best == -1ULL ? 0 : best;
+        }
+
+        //! Distinct values of L[l..r] in increasing order
+        std::vector<value_type> all_values_in_range(size_type l, size_type r) const {
+            std::vector<value_type> res;
+            if (m_size == 0 || l > r) return res;
+            for (auto k : m_K.all_values_in_range(l, r)) {
+                if (single(k)) {
+                    res.push_back(symbol(k, 0));
+                    continue;
+                }
+                for (auto o : m_seqs[k].all_values_in_range(m_K.rank(l, k), m_K.rank(r + 1, k) - 1)) {
+                    res.push_back(symbol(k, o));
+                }
+            }
+            std::sort(res.begin(), res.end());
+            return res;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, "wt_ap");
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_sigma, out, child, "sigma");
+            written_bytes += sdsl::write_member(m_classes, out, child, "classes");
+            written_bytes += m_map.serialize(out, child, "map");
+            written_bytes += m_K.serialize(out, child, "K");
+            for (uint64_t k = 0; k < m_classes; ++k) {
+                written_bytes += m_seqs[k].serialize(out, child, "seq_" + std::to_string(k));
+            }
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(m_sigma, in);
+            sdsl::read_member(m_classes, in);
+            m_map.load(in);
+            m_K.load(in);
+            m_seqs.resize(m_classes);
+            for (uint64_t k = 0; k < m_classes; ++k) {
+                m_seqs[k].load(in);
+            }
+        }
+    };
+
+    template <class t_class_seq, class t_seq>
+    void construct_im(wt_ap<t_class_seq, t_seq> &wt, const int_vector<> &L) {
+        wt = wt_ap<t_class_seq, t_seq>(L);
+    }
+}
+
+#endif
@@ -32,6 +32,55 @@ do
 	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring
 done
 
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-simd $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-simd ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-simd
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-cl $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-cl ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-cl
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-alpha $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-alpha ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-alpha
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-ap $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-ap ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-ap
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-delta $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-delta ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-delta
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-dyn-read $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-dyn-read ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-dyn-read
+done
+
+for file in ../$2/bgps/*.txt
+do
+	queryName=$(basename $file)
+  echo Processing ring-dyn-update $queryName
+	./query-index ../$1/wikidata-wcg-filtered-num.nt.ring-dyn-update ../$2/bgps/$queryName ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/bgps/output/${queryName%%.txt}/ring-dyn-update
+done
+
 for file in ../$2/bgps/*.txt
 do
 	queryName=$(basename $file)
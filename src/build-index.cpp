@@ -19,19 +19,34 @@
 
 #include <iostream>
 #include "ring.hpp"
+#include "ring_delta.hpp"
 #include "dict_map.hpp"
 #include <fstream>
 #include <regex>
 #include <sdsl/construct.hpp>
 #include <ltj_algorithm.hpp>
+#include <stats_catalog.hpp>
 
 using namespace std;
 
 using namespace std::chrono;
 using timer = std::chrono::high_resolution_clock;
 
+// Statistics of the predicates for the cost-based planner; removes stale ones if they are not built
+void store_stats(const vector<spo_triple> &D, const std::string &output, const bool stats)
+{
+    if (!stats)
+    {
+        std::remove(::ring::stats_catalog::file_of(output).c_str());
+        return;
+    }
+    ::ring::stats_catalog catalog(D);
+    sdsl::store_to_file(catalog, ::ring::stats_catalog::file_of(output));
+    cout << "Statistics saved" << endl;
+}
+
 template <class ring>
-void build_index(const std::string &dataset, const std::string &output)
+void build_index(const std::string &dataset, const std::string &output, const bool stats)
 {
     vector<spo_triple> D, E;
 
@@ -55,6 +70,7 @@ void build_index(const std::string &dataset, const std::string &output)
 
     sdsl::store_to_file(A, output);
     cout << "Index saved" << endl;
+    store_stats(D, output, stats);
     cout << duration_cast<seconds>(stop - start).count() << " seconds." << endl;
     cout << memory_monitor::peak() << " bytes." << endl;
 }
@@ -102,7 +118,7 @@ void build_mapping(const std::string &dataset, std::vector<spo_triple> &D)
 }
 
 template <class ring, class map>
-void build_index_mapped(const std::string &dataset, const std::string &output)
+void build_index_mapped(const std::string &dataset, const std::string &output, const bool stats)
 {
     vector<spo_triple> D, E;
 
@@ -119,6 +135,7 @@ void build_index_mapped(const std::string &dataset, const std::string &output)
     cout << "  Index built  " << sdsl::size_in_bytes(A) << " bytes" << endl;
     sdsl::store_to_file(A, output);
     cout << "Index saved" << endl;
+    store_stats(D, output, stats);
     cout << duration_cast<seconds>(stop - start).count() << " seconds." << endl;
     cout << memory_monitor::peak() << " bytes." << endl;
 }
@@ -126,9 +143,11 @@ void build_index_mapped(const std::string &dataset, const std::string &output)
 int main(int argc, char **argv)
 {
 
-    if (argc != 3)
+    // Optional last argument: build the statistics of the predicates (stats)
+    bool stats = argc == 4 && std::string(argv[3]) == "stats";
+    if (argc != 3 && !stats)
     {
-        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel|ring-simd|ring-cl|ring-alpha|ring-ap|ring-delta] [stats]" << std::endl;
         return 0;
     }
 
@@ -137,36 +156,71 @@ int main(int argc, char **argv)
     if (type == "ring")
     {
         std::string index_name = dataset + ".ring";
-        build_index<ring::ring<>>(dataset, index_name);
+        build_index<ring::ring<>>(dataset, index_name, stats);
     }
     else if (type == "c-ring")
     {
         std::string index_name = dataset + ".c-ring";
-        build_index<ring::c_ring>(dataset, index_name);
+        build_index<ring::c_ring>(dataset, index_name, stats);
     }
     else if (type == "ring-sel")
     {
         std::string index_name = dataset + ".ring-sel";
-        build_index<ring::ring_sel>(dataset, index_name);
+        build_index<ring::ring_sel>(dataset, index_name, stats);
+    }
+    else if (type == "ring-simd")
+    {
+        std::string index_name = dataset + ".ring-simd";
+        build_index<ring::ring_simd>(dataset, index_name, stats);
+    }
+    else if (type == "ring-cl")
+    {
+        std::string index_name = dataset + ".ring-cl";
+        build_index<ring::ring_cl>(dataset, index_name, stats);
+    }
+    else if (type == "ring-alpha")
+    {
+        std::string index_name = dataset + ".ring-alpha";
+        build_index<ring::ring_alpha>(dataset, index_name, stats);
+    }
+    else if (type == "ring-ap")
+    {
+        std::string index_name = dataset + ".ring-ap";
+        build_index<ring::ring_ap>(dataset, index_name, stats);
+    }
+    else if (type == "ring-delta")
+    {
+        std::string index_name = dataset + ".ring-delta";
+        build_index<ring::ring_delta<>>(dataset, index_name, stats);
     }
     else if (type == "ring-dyn-basic")
     {
         std::string index_name = dataset + ".ring-dyn-basic";
-        build_index<ring::ring_dyn>(dataset, index_name);
+        build_index<ring::ring_dyn>(dataset, index_name, stats);
     }
     else if (type == "ring-dyn")
     {
         std::string index_name = dataset + ".ring-dyn";
-        build_index<ring::medium_ring_dyn>(dataset, index_name);
+        build_index<ring::medium_ring_dyn>(dataset, index_name, stats);
+    }
+    else if (type == "ring-dyn-read")
+    {
+        std::string index_name = dataset + ".ring-dyn-read";
+        build_index<ring::read_ring_dyn>(dataset, index_name, stats);
+    }
+    else if (type == "ring-dyn-update")
+    {
+        std::string index_name = dataset + ".ring-dyn-update";
+        build_index<ring::update_ring_dyn>(dataset, index_name, stats);
     }
     else if (type == "ring-dyn-map")
     {
         std::string index_name = dataset + ".ring-dyn";
-        build_index_mapped<ring::medium_ring_dyn, ring::basic_map>(dataset, index_name);
+        build_index_mapped<ring::medium_ring_dyn, ring::basic_map>(dataset, index_name, stats);
     }
     else
     {
-        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel|ring-dyn|ring-dyn-map]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel|ring-simd|ring-cl|ring-alpha|ring-ap|ring-delta|ring-dyn|ring-dyn-read|ring-dyn-update|ring-dyn-map] [stats]" << std::endl;
     }
 
     return 0;
@@ -0,0 +1,291 @@
+/*
+ * compact-index.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <future>
+#include "ring.hpp"
+#include <chrono>
+#include <triple_pattern.hpp>
+#include <ltj_algorithm.hpp>
+#include "utils.hpp"
+
+using namespace std;
+
+using namespace std::chrono;
+
+bool get_file_content(string filename, vector<string> &vector_of_strings)
+{
+    // Open the File
+    ifstream in(filename.c_str());
+    // Check if object is valid
+    if (!in)
+    {
+        cerr << "Cannot open the File : " << filename << endl;
+        return false;
+    }
+    string str;
+    // Read the next line from File until it reaches the end.
+    while (getline(in, str))
+    {
+        // Line contains string of length > 0 then save it in vector
+        if (str.size() > 0)
+            vector_of_strings.push_back(str);
+    }
+    // Close The File
+    in.close();
+    return true;
+}
+
+std::string ltrim(const std::string &s)
+{
+    size_t start = s.find_first_not_of(' ');
+    return (start == std::string::npos) ? "" : s.substr(start);
+}
+
+std::string rtrim(const std::string &s)
+{
+    size_t end = s.find_last_not_of(' ');
+    return (end == std::string::npos) ? "" : s.substr(0, end + 1);
+}
+
+std::string trim(const std::string &s)
+{
+    return rtrim(ltrim(s));
+}
+
+std::vector<std::string> tokenizer(const std::string &input, const char &delimiter)
+{
+    std::stringstream stream(input);
+    std::string token;
+    std::vector<std::string> res;
+    while (getline(stream, token, delimiter))
+    {
+        res.emplace_back(trim(token));
+    }
+    return res;
+}
+
+bool is_variable(string &s)
+{
+    return (s.at(0) == '?');
+}
+
+uint8_t get_variable(string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars)
+{
+    auto var = s.substr(1);
+    auto it = hash_table_vars.find(var);
+    if (it == hash_table_vars.end())
+    {
+        uint8_t id = hash_table_vars.size();
+        hash_table_vars.insert({var, id});
+        return id;
+    }
+    else
+    {
+        return it->second;
+    }
+}
+
+uint64_t get_constant(string &s)
+{
+    return std::stoull(s);
+}
+
+ring::triple_pattern get_triple(string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars)
+{
+    vector<string> terms = tokenizer(s, ' ');
+
+    ring::triple_pattern triple;
+    if (is_variable(terms[0]))
+    {
+        triple.var_s(get_variable(terms[0], hash_table_vars));
+    }
+    else
+    {
+        triple.const_s(get_constant(terms[0]));
+    }
+    if (is_variable(terms[1]))
+    {
+        triple.var_p(get_variable(terms[1], hash_table_vars));
+    }
+    else
+    {
+        triple.const_p(get_constant(terms[1]));
+    }
+    if (is_variable(terms[2]))
+    {
+        triple.var_o(get_variable(terms[2], hash_table_vars));
+    }
+    else
+    {
+        triple.const_o(get_constant(terms[2]));
+    }
+    return triple;
+}
+
+std::string get_type(const std::string &file)
+{
+    auto p = file.find_last_of('.');
+    return file.substr(p + 1);
+}
+
+template <class ring_type>
+uint64_t run_query(ring_type *graph, std::vector<ring::triple_pattern> &query)
+{
+    typedef std::vector<typename ring::ltj_algorithm<>::tuple_type> results_type;
+    ring::ltj_algorithm<ring_type> ltj(&query, graph);
+    results_type res;
+    ltj.join(res, 1000, 600);
+    return res.size();
+}
+
+/**
+ * Rebuilds a dynamic ring as a static one in a background thread. Meanwhile the
+ * queries (if any) are answered by the dynamic ring; once the static ring is
+ * ready the remaining ones are answered by it.
+ *
+ * The two threads never share a structure: the background thread loads its own
+ * copy of the dynamic ring from the file and compacts it, so the queries do not
+ * depend on the DYNAMIC structures being safe for concurrent reads. This costs a
+ * second copy of the dynamic ring while the compaction runs.
+ */
+template <class ring_dyn_type, class ring_static_type>
+void compact_index(const std::string &file, const std::string &output, const std::string &queries)
+{
+    vector<string> dummy_queries;
+    if (!queries.empty())
+        get_file_content(queries, dummy_queries);
+
+    std::shared_ptr<ring_dyn_type> dyn_graph = std::make_shared<ring_dyn_type>();
+
+    cout << " Loading the index...";
+    fflush(stdout);
+    sdsl::load_from_file(*dyn_graph, file);
+
+    cout << endl
+         << " Index loaded " << sdsl::size_in_bytes(*dyn_graph) << " bytes" << endl;
+
+    // The time of the compaction includes loading its copy of the dynamic ring
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    std::future<std::shared_ptr<ring_static_type>> compaction = std::async(std::launch::async, [file]() {
+        ring_dyn_type copy;
+        sdsl::load_from_file(copy, file);
+        return std::make_shared<ring_static_type>(copy.template compact<ring_static_type>());
+    });
+
+    std::shared_ptr<ring_static_type> static_graph;
+    high_resolution_clock::time_point stop;
+    uint64_t nQ = 0;
+    for (string &query_string : dummy_queries)
+    {
+        std::unordered_map<std::string, uint8_t> hash_table_vars;
+        std::vector<ring::triple_pattern> query;
+        vector<string> tokens_query = tokenizer(query_string, '.');
+        for (string &token : tokens_query)
+        {
+            auto triple_pattern = get_triple(token, hash_table_vars);
+            query.push_back(triple_pattern);
+        }
+
+        // Swap to the static ring as soon as it is ready
+        if (!static_graph && compaction.wait_for(seconds(0)) == std::future_status::ready)
+        {
+            static_graph = compaction.get();
+            stop = high_resolution_clock::now();
+            dyn_graph.reset();
+        }
+
+        high_resolution_clock::time_point q_start = high_resolution_clock::now();
+        uint64_t n_res = static_graph ? run_query(static_graph.get(), query) : run_query(dyn_graph.get(), query);
+        high_resolution_clock::time_point q_stop = high_resolution_clock::now();
+        duration<double> time_span = duration_cast<microseconds>(q_stop - q_start);
+        double total_time = time_span.count();
+
+        cout << nQ << ";" << (static_graph ? "static" : "dynamic") << ";" << n_res << ";" << (unsigned long long)(total_time * 1000000000ULL) << endl;
+        nQ++;
+    }
+
+    if (!static_graph)
+    {
+        static_graph = compaction.get();
+        stop = high_resolution_clock::now();
+        dyn_graph.reset();
+    }
+
+    cout << "  Index compacted " << sdsl::size_in_bytes(*static_graph) << " bytes, "
+         << static_graph->n_triples() << " triples" << endl;
+    cout << duration_cast<milliseconds>(stop - start).count() << " milliseconds." << endl;
+    sdsl::store_to_file(*static_graph, output);
+    cout << "Index saved" << endl;
+}
+
+template <class ring_dyn_type>
+void compact_to(const std::string &index, const std::string &type, const std::string &queries)
+{
+    std::string output = index.substr(0, index.find_last_of('.')) + "." + type;
+    if (type == "ring")
+    {
+        compact_index<ring_dyn_type, ring::ring<>>(index, output, queries);
+    }
+    else if (type == "ring-sel")
+    {
+        compact_index<ring_dyn_type, ring::ring_sel>(index, output, queries);
+    }
+    else
+    {
+        std::cout << "Type of output index: " << type << " is not supported." << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <index> [ring|ring-sel] [<queries>]" << std::endl;
+        return 0;
+    }
+
+    std::string index = argv[1];
+    std::string type = argv[2];
+    std::string queries = argc == 4 ? argv[3] : "";
+    std::string in_type = get_type(index);
+
+    if (in_type == "ring-dyn-basic")
+    {
+        compact_to<ring::ring_dyn>(index, type, queries);
+    }
+    else if (in_type == "ring-dyn")
+    {
+        compact_to<ring::medium_ring_dyn>(index, type, queries);
+    }
+    else if (in_type == "ring-dyn-read")
+    {
+        compact_to<ring::read_ring_dyn>(index, type, queries);
+    }
+    else if (in_type == "ring-dyn-update")
+    {
+        compact_to<ring::update_ring_dyn>(index, type, queries);
+    }
+    else
+    {
+        std::cout << "Type of index: " << in_type << " is not supported." << std::endl;
+    }
+
+    return 0;
+}
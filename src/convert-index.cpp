@@ -0,0 +1,162 @@
+/*
+ * convert-index.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include "ring.hpp"
+#include "chunk_store.hpp"
+#include <fstream>
+#include <sdsl/construct.hpp>
+
+using namespace std;
+
+using namespace std::chrono;
+using timer = std::chrono::high_resolution_clock;
+
+std::string get_type(const std::string &file)
+{
+    auto p = file.find_last_of('.');
+    return file.substr(p + 1);
+}
+
+template <class ring_in, class ring_out>
+void convert_index(const std::string &index, const std::string &output)
+{
+    ring_in A;
+    cout << " Loading the index..." << endl;
+    ring::load_index(A, index);
+    cout << " Index loaded " << sdsl::size_in_bytes(A) << " bytes" << endl;
+
+    cout << "--Converting " << A.n_triples() << " triples" << endl;
+    memory_monitor::start();
+    auto start = timer::now();
+
+    ring_out B(A);
+    auto stop = timer::now();
+    memory_monitor::stop();
+    cout << "  Index converted " << sdsl::size_in_bytes(B) << " bytes" << endl;
+
+    sdsl::store_to_file(B, output);
+    cout << "Index saved" << endl;
+    cout << duration_cast<seconds>(stop - start).count() << " seconds." << endl;
+    cout << memory_monitor::peak() << " bytes." << endl;
+}
+
+template <class ring_type>
+void page_index(const std::string &index, bool paged)
+{
+    ring_type A;
+    cout << " Loading the index..." << endl;
+    ring::load_index(A, index);
+    cout << " Index loaded " << sdsl::size_in_bytes(A) << " bytes" << endl;
+
+    auto start = timer::now();
+    if (paged)
+    {
+        ring::chunk_store store(index);
+        store.store(A);
+        cout << "  Index stored paged: " << store.written_chunks() << " chunks, "
+             << store.written_bytes() << " bytes written" << endl;
+    }
+    else
+    {
+        sdsl::store_to_file(A, index + ".tmp");
+        std::rename((index + ".tmp").c_str(), index.c_str());
+        cout << "  Index stored in a single file; " << index << ".chunks can be removed" << endl;
+    }
+    auto stop = timer::now();
+    cout << duration_cast<milliseconds>(stop - start).count() << " ms." << endl;
+}
+
+template <class ring_in>
+void convert_to(const std::string &index, const std::string &type)
+{
+    std::string output = index.substr(0, index.find_last_of('.')) + "." + type;
+    if (type == "paged" || type == "flat")
+    {
+        page_index<ring_in>(index, type == "paged");
+    }
+    else if (type == "ring-dyn-basic")
+    {
+        convert_index<ring_in, ring::ring_dyn>(index, output);
+    }
+    else if (type == "ring-dyn")
+    {
+        convert_index<ring_in, ring::medium_ring_dyn>(index, output);
+    }
+    else if (type == "ring-dyn-read")
+    {
+        convert_index<ring_in, ring::read_ring_dyn>(index, output);
+    }
+    else if (type == "ring-dyn-update")
+    {
+        convert_index<ring_in, ring::update_ring_dyn>(index, output);
+    }
+    else
+    {
+        std::cout << "Type of output index: " << type << " is not supported." << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <index> [ring-dyn-basic|ring-dyn|ring-dyn-read|ring-dyn-update|paged|flat]" << std::endl;
+        return 0;
+    }
+
+    std::string index = argv[1];
+    std::string type = argv[2];
+    std::string in_type = get_type(index);
+
+    if (in_type == "ring")
+    {
+        convert_to<ring::ring<>>(index, type);
+    }
+    else if (in_type == "ring-sel")
+    {
+        convert_to<ring::ring_sel>(index, type);
+    }
+    else if (in_type == "c-ring")
+    {
+        convert_to<ring::c_ring>(index, type);
+    }
+    else if (in_type == "ring-dyn-basic")
+    {
+        convert_to<ring::ring_dyn>(index, type);
+    }
+    else if (in_type == "ring-dyn")
+    {
+        convert_to<ring::medium_ring_dyn>(index, type);
+    }
+    else if (in_type == "ring-dyn-read")
+    {
+        convert_to<ring::read_ring_dyn>(index, type);
+    }
+    else if (in_type == "ring-dyn-update")
+    {
+        convert_to<ring::update_ring_dyn>(index, type);
+    }
+    else
+    {
+        std::cout << "Type of index: " << in_type << " is not supported." << std::endl;
+    }
+
+    return 0;
+}
@@ -20,7 +20,9 @@
 #include <iostream>
 #include <utility>
 #include "ring.hpp"
+#include "ring_delta.hpp"
 #include "dict_map.hpp"
+#include "update_log.hpp"
 #include <chrono>
 #include <triple_pattern.hpp>
 #include <ltj_algorithm.hpp>
@@ -283,11 +285,34 @@ void mapped_delete_query(const std::string &file, const std::string &so_mapping_
     }
 }
 
+// The updates of the queries file, with terms if the index is mapped
+void get_updates(const std::string &queries, const bool mapped, std::vector<ring::update_log::record> &updates)
+{
+    if (!mapped)
+    {
+        vector<spo_triple> values;
+        get_triples_from_file(queries, values);
+        for (const spo_triple &triple : values)
+            updates.push_back(ring::update_log::delete_edge(triple));
+        return;
+    }
+    vector<string> lines;
+    get_file_content(queries, lines);
+    regex token_regex("(?:\".*\"|[^[:space:]])+");
+    for (const string &line : lines)
+    {
+        size_t b = line.find_first_of("{"),
+               e = line.find_last_of("}");
+        vector<string> terms = regex_tokenizer(line.substr(b + 1, e - b - 1), token_regex);
+        updates.push_back(ring::update_log::delete_edge(terms[0], terms[1], terms[2]));
+    }
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 3 && argc != 5)
+    if (argc < 3 || argc > 6)
     {
-        std::cout << "Usage: " << argv[0] << " <index> <queries>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <index> <queries> [<so mapping> <p mapping>] [<log>]" << std::endl;
         return 0;
     }
 
@@ -305,6 +330,18 @@ int main(int argc, char *argv[])
         {
             delete_query<ring::medium_ring_dyn>(index, queries);
         }
+        else if (type == "ring-dyn-read")
+        {
+            delete_query<ring::read_ring_dyn>(index, queries);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            delete_query<ring::update_ring_dyn>(index, queries);
+        }
+        else if (type == "ring-delta")
+        {
+            delete_query<ring::ring_delta<>>(index, queries);
+        }
         else
         {
             std::cout << "Type of index: " << type << " is not supported." << std::endl;
@@ -323,11 +360,32 @@ int main(int argc, char *argv[])
         {
             mapped_delete_query<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
         }
+        else if (type == "ring-dyn-read")
+        {
+            mapped_delete_query<ring::read_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            mapped_delete_query<ring::update_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+        }
         else
         {
             std::cout << "Type of index: " << type << " is not supported." << std::endl;
         }
     }
 
+    if (argc == 4 || argc == 6)
+    {
+        std::string log = argv[argc - 1];
+        std::string so_mapping = argc == 6 ? argv[3] : "";
+        std::string p_mapping = argc == 6 ? argv[4] : "";
+        std::vector<ring::update_log::record> updates;
+        get_updates(queries, argc == 6, updates);
+        if (!ring::logged_updates(type, index, so_mapping, p_mapping, log, updates))
+        {
+            std::cout << "Type of index: " << type << " does not support logging." << std::endl;
+        }
+    }
+
     return 0;
 }
@@ -21,6 +21,7 @@
 #include <utility>
 #include "ring.hpp"
 #include "dict_map.hpp"
+#include "update_log.hpp"
 #include <chrono>
 #include <triple_pattern.hpp>
 #include <ltj_algorithm.hpp>
@@ -197,15 +198,8 @@ void mapped_delete_query(const std::string &file, const std::string &so_mapping_
 
             start = high_resolution_clock::now();
 
-            for (uint64_t id : so_removed_ids)
-            {
-                so_mapping.eliminate(id);
-            }
-
-            for (uint64_t id : p_removed_ids)
-            {
-                p_mapping.eliminate(id);
-            }
+            so_mapping.eliminate_batch(so_removed_ids);
+            p_mapping.eliminate_batch(p_removed_ids);
 
             stop = high_resolution_clock::now();
             time_span = duration_cast<microseconds>(stop - start);
@@ -219,11 +213,28 @@ void mapped_delete_query(const std::string &file, const std::string &so_mapping_
     }
 }
 
+// The updates of the queries file, with terms if the index is mapped
+void get_updates(const std::string &queries, const bool mapped, std::vector<ring::update_log::record> &updates)
+{
+    if (!mapped)
+    {
+        vector<uint64_t> values;
+        get_values_from_file(queries, values);
+        for (uint64_t value : values)
+            updates.push_back(ring::update_log::delete_node(value));
+        return;
+    }
+    vector<string> lines;
+    get_file_content(queries, lines);
+    for (const string &line : lines)
+        updates.push_back(ring::update_log::delete_node(get_node_value(line)));
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 3 && argc != 5)
+    if (argc < 3 || argc > 6)
     {
-        std::cout << "Usage: " << argv[0] << " <index> <queries>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <index> <queries> [<so mapping> <p mapping>] [<log>]" << std::endl;
         return 0;
     }
 
@@ -241,6 +252,14 @@ int main(int argc, char *argv[])
         {
             delete_query<ring::medium_ring_dyn>(index, queries);
         }
+        else if (type == "ring-dyn-read")
+        {
+            delete_query<ring::read_ring_dyn>(index, queries);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            delete_query<ring::update_ring_dyn>(index, queries);
+        }
         else
         {
             std::cout << "Type of index: " << type << " is not supported." << std::endl;
@@ -259,11 +278,32 @@ int main(int argc, char *argv[])
         {
             mapped_delete_query<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
         }
+        else if (type == "ring-dyn-read")
+        {
+            mapped_delete_query<ring::read_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            mapped_delete_query<ring::update_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+        }
         else
         {
             std::cout << "Type of index: " << type << " is not supported." << std::endl;
         }
     }
 
+    if (argc == 4 || argc == 6)
+    {
+        std::string log = argv[argc - 1];
+        std::string so_mapping = argc == 6 ? argv[3] : "";
+        std::string p_mapping = argc == 6 ? argv[4] : "";
+        std::vector<ring::update_log::record> updates;
+        get_updates(queries, argc == 6, updates);
+        if (!ring::logged_updates(type, index, so_mapping, p_mapping, log, updates))
+        {
+            std::cout << "Type of index: " << type << " does not support logging." << std::endl;
+        }
+    }
+
     return 0;
 }
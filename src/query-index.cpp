@@ -20,10 +20,17 @@
 #include <iostream>
 #include <utility>
 #include "ring.hpp"
+#include "ring_delta.hpp"
 #include "dict_map.hpp"
+#include "chunk_store.hpp"
 #include <chrono>
 #include <triple_pattern.hpp>
 #include <ltj_algorithm.hpp>
+#include <stats_catalog.hpp>
+#include <plan_cache.hpp>
+#include <interval_cache.hpp>
+#include <ltj_union.hpp>
+#include <ltj_optional.hpp>
 #include "utils.hpp"
 
 using namespace std;
@@ -85,12 +92,17 @@ std::vector<std::string> tokenizer(const std::string &input, const char &delimit
     return res;
 }
 
-std::vector<std::string> parse_select(const std::string &input)
+// Patterns between the braces of the WHERE clause
+std::string select_body(const std::string &input)
 {
-    std::vector<std::string> res;
     size_t start = input.find_first_of("{"),
            end = input.find_last_of("}");
-    std::string query = input.substr(start + 1, end - start - 1);
+    return input.substr(start + 1, end - start - 1);
+}
+
+std::vector<std::string> split_triples(const std::string &query)
+{
+    std::vector<std::string> res;
     size_t index = 0, tmp_index = 0;
     while (tmp_index < query.size())
     {
@@ -178,7 +190,7 @@ ring::triple_pattern get_triple(string &s, std::unordered_map<std::string, uint8
 template <class map_type>
 ring::triple_pattern get_user_triple(string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars, map_type &so_mapping, map_type &p_mapping)
 {
-    std::regex token_regex("(?:\".*\"|[^[:space:]])+");
+    static const std::regex token_regex("(?:\".*\"|[^[:space:]])+");
     vector<string> terms = regex_tokenizer(s, token_regex);
 
     ring::triple_pattern triple;
@@ -209,6 +221,256 @@ ring::triple_pattern get_user_triple(string &s, std::unordered_map<std::string,
     return triple;
 }
 
+// Removes the FILTER (...) clauses of a BGP and returns their expressions
+std::vector<std::string> extract_filters(std::string &bgp)
+{
+    std::vector<std::string> res;
+    size_t pos;
+    while ((pos = bgp.find("FILTER")) != std::string::npos)
+    {
+        size_t open = bgp.find('(', pos), end = open;
+        if (open == std::string::npos)
+            break;
+        for (int depth = 0; end < bgp.size(); ++end)
+        {
+            if (bgp[end] == '(')
+                ++depth;
+            else if (bgp[end] == ')' && --depth == 0)
+                break;
+        }
+        res.emplace_back(trim(bgp.substr(open + 1, end - open - 1)));
+        bgp.erase(pos, end + 1 - pos);
+    }
+    bgp = trim(bgp);
+    if (!bgp.empty() && bgp.back() == '.')
+    {
+        bgp.pop_back();
+        bgp = trim(bgp);
+    }
+    return res;
+}
+
+// Splits a filter expression ?x op term, with op one of = != < <= > >=
+bool split_filter(const std::string &expr, std::string &var, ring::filter_pattern::op_type &op, std::string &term)
+{
+    size_t end = expr.find_first_of(" !=<>");
+    if (expr.empty() || expr[0] != '?' || end == std::string::npos)
+        return false;
+    var = expr.substr(0, end);
+    size_t pos = expr.find_first_not_of(' ', end);
+    if (pos == std::string::npos)
+        return false;
+    bool or_equal = pos + 1 < expr.size() && expr[pos + 1] == '=';
+    switch (expr[pos])
+    {
+    case '=':
+        op = ring::filter_pattern::equal;
+        break;
+    case '!':
+        if (!or_equal)
+            return false;
+        op = ring::filter_pattern::not_equal;
+        break;
+    case '<':
+        op = or_equal ? ring::filter_pattern::less_equal : ring::filter_pattern::less;
+        break;
+    case '>':
+        op = or_equal ? ring::filter_pattern::greater_equal : ring::filter_pattern::greater;
+        break;
+    default:
+        return false;
+    }
+    term = trim(expr.substr(pos + ((or_equal || expr[pos] == '!') ? 2 : 1)));
+    return !term.empty();
+}
+
+ring::filter_pattern get_filter(const std::string &expr, std::unordered_map<std::string, uint8_t> &hash_table_vars)
+{
+    std::string var, term;
+    ring::filter_pattern filter;
+    if (!split_filter(expr, var, filter.op, term))
+        throw std::invalid_argument("Unsupported FILTER: " + expr);
+    filter.var = get_variable(var, hash_table_vars);
+    filter.term.is_variable = is_variable(term);
+    filter.term.value = filter.term.is_variable ? get_variable(term, hash_table_vars) : get_constant(term);
+    return filter;
+}
+
+// The constants of the filters on a variable in the predicates of some BGP are predicates.
+// A constant missing from the dictionary never holds with '=', is dropped with '!=' (returns
+// false), and bounds the ranges with the ID of its nearest term in the dictionary
+template <class map_type>
+bool get_user_filter(const std::string &expr, std::unordered_map<std::string, uint8_t> &hash_table_vars,
+                     const std::vector<std::vector<ring::triple_pattern>> &bgps, map_type &so_mapping,
+                     map_type &p_mapping, ring::filter_pattern &filter)
+{
+    std::string var, term;
+    if (!split_filter(expr, var, filter.op, term))
+        throw std::invalid_argument("Unsupported FILTER: " + expr);
+    filter.var = get_variable(var, hash_table_vars);
+    filter.term.is_variable = is_variable(term);
+    if (filter.term.is_variable)
+    {
+        filter.term.value = get_variable(term, hash_table_vars);
+        return true;
+    }
+    bool is_predicate = false;
+    for (const auto &bgp : bgps)
+    {
+        for (const auto &triple : bgp)
+        {
+            if (triple.p_is_variable() && triple.term_p.value == filter.var)
+                is_predicate = true;
+        }
+    }
+    map_type &mapping = is_predicate ? p_mapping : so_mapping;
+    filter.term.value = mapping.locate_batch({term})[0];
+    if (filter.term.value != 0)
+        return true;
+
+    std::pair<uint64_t, uint64_t> neighbours = mapping.locate_neighbours(term);
+    switch (filter.op)
+    {
+    case ring::filter_pattern::not_equal:
+        return false;
+    case ring::filter_pattern::greater:
+    case ring::filter_pattern::greater_equal:
+        filter.op = ring::filter_pattern::greater_equal;
+        filter.term.value = neighbours.second;
+        break;
+    case ring::filter_pattern::less:
+    case ring::filter_pattern::less_equal:
+        filter.op = ring::filter_pattern::less_equal;
+        filter.term.value = neighbours.first;
+        break;
+    default:
+        break;
+    }
+    // No value is less than 0: the filter never holds
+    if (filter.term.value == 0)
+        filter.op = ring::filter_pattern::less;
+    return true;
+}
+
+struct solution_modifiers
+{
+    std::string order_var; // without '?', empty if there is no ORDER BY
+    bool descending = false;
+    uint64_t limit = 1000;
+};
+
+// Removes the ORDER BY ?x (or DESC(?x)) and LIMIT k clauses that follow the patterns of the query
+solution_modifiers parse_modifiers(std::string &query)
+{
+    solution_modifiers mod;
+    size_t from = query.find_last_of('}');
+    if (from == std::string::npos)
+        from = 0;
+    size_t order = query.find("ORDER BY", from), limit = query.find("LIMIT", from);
+    if (order != std::string::npos)
+    {
+        size_t end = (limit != std::string::npos && limit > order) ? limit : query.size();
+        std::string var = trim(query.substr(order + 8, end - order - 8));
+        if (var.compare(0, 4, "DESC") == 0)
+        {
+            mod.descending = true;
+            var = var.substr(4);
+        }
+        else if (var.compare(0, 3, "ASC") == 0)
+        {
+            var = var.substr(3);
+        }
+        size_t p = var.find('?');
+        if (p != std::string::npos)
+        {
+            mod.order_var = var.substr(p + 1, var.find_first_of(") ", p) - p - 1);
+        }
+    }
+    if (limit != std::string::npos)
+    {
+        mod.limit = std::stoull(query.substr(limit + 5));
+    }
+    query = query.substr(0, std::min(order, limit));
+    return mod;
+}
+
+template <class ltj_type, class results_type>
+void solve(ltj_type &ltj, const solution_modifiers &mod, std::unordered_map<std::string, uint8_t> &hash_table_vars, results_type &res)
+{
+    auto it = hash_table_vars.find(mod.order_var);
+    if (it == hash_table_vars.end())
+    {
+        ltj.join(res, mod.limit, 600);
+    }
+    else
+    {
+        ltj.join_top_k(res, it->second, mod.limit, mod.descending, 600);
+    }
+}
+
+// BGPs of a query: one BGP, the branches of a UNION ({ A } UNION { B } ...)
+// or a BGP followed by its OPTIONAL BGPs (A OPTIONAL { B } OPTIONAL { C } ...)
+struct query_groups
+{
+    bool is_union = false;
+    std::vector<std::string> parts; // without braces
+};
+
+query_groups parse_groups(const std::string &query)
+{
+    query_groups groups;
+    std::string keyword = "OPTIONAL";
+    if (query.find("UNION") != std::string::npos)
+    {
+        groups.is_union = true;
+        keyword = "UNION";
+    }
+    size_t index = 0;
+    while (true)
+    {
+        size_t next = query.find(keyword, index);
+        std::string part = trim(query.substr(index, next == std::string::npos ? std::string::npos : next - index));
+        if (!part.empty() && part.front() == '{')
+            part = part.substr(1);
+        if (!part.empty() && part.back() == '}')
+            part.pop_back();
+        groups.parts.emplace_back(trim(part));
+        if (next == std::string::npos)
+            break;
+        index = next + keyword.size();
+    }
+    return groups;
+}
+
+// Solves the BGPs of a query: one BGP, the UNION of all of them, or the first one with the others as OPTIONAL
+template <class gao_type, class ring_type, class results_type>
+void evaluate(const query_groups &groups, const std::vector<std::vector<ring::triple_pattern>> &bgps,
+              const std::vector<std::vector<ring::filter_pattern>> &filters, ring_type &graph,
+              const bool adaptive, const ring::stats_catalog *stats, ring::plan_cache<> *plans, ring::interval_cache *intervals,
+              const bool semijoin, const solution_modifiers &mod, std::unordered_map<std::string, uint8_t> &hash_table_vars, results_type &res)
+{
+    if (groups.is_union)
+    {
+        ring::ltj_union<ring_type, uint8_t, uint64_t, gao_type> ltj(&bgps, &graph, adaptive, stats, plans, intervals, &filters);
+        solve(ltj, mod, hash_table_vars, res);
+    }
+    else if (bgps.size() > 1)
+    {
+        std::vector<std::vector<ring::triple_pattern>> optionals(bgps.begin() + 1, bgps.end());
+        std::vector<std::vector<ring::filter_pattern>> optional_filters(filters.begin() + 1, filters.end());
+        ring::ltj_optional<ring_type, uint8_t, uint64_t, gao_type> ltj(&bgps[0], &optionals, &graph, adaptive, stats, plans, intervals,
+                                                                       &filters[0], &optional_filters);
+        solve(ltj, mod, hash_table_vars, res);
+    }
+    else
+    {
+        ring::ltj_algorithm<ring_type, uint8_t, uint64_t, gao_type> ltj(&bgps[0], &graph, adaptive, stats, plans, intervals, &filters[0]);
+        if (semijoin)
+            ltj.semi_join_reduce();
+        solve(ltj, mod, hash_table_vars, res);
+    }
+}
+
 std::string get_type(const std::string &file)
 {
     auto p = file.find_last_of('.');
@@ -216,7 +478,7 @@ std::string get_type(const std::string &file)
 }
 
 template <class ring_type>
-void query(const std::string &file, const std::string &queries)
+void query(const std::string &file, const std::string &queries, const bool adaptive, const bool cost, const bool cache, const bool intervals, const bool semijoin)
 {
     vector<string> dummy_queries;
     bool result = get_file_content(queries, dummy_queries);
@@ -225,11 +487,23 @@ void query(const std::string &file, const std::string &queries)
 
     cout << " Loading the index...";
     fflush(stdout);
-    sdsl::load_from_file(graph, file);
+    ring::load_index(graph, file);
 
     cout << endl
          << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
 
+    // Statistics for the planner, if they are up to date
+    ring::stats_catalog stats;
+    const ring::stats_catalog *ptr_stats = ring::load_stats(stats, graph, file) ? &stats : nullptr;
+
+    // Plans of the shapes already seen
+    ring::plan_cache<> plans;
+    ring::plan_cache<> *ptr_plans = cache ? &plans : nullptr;
+
+    // Intervals of the constants already resolved
+    ring::interval_cache interval_states;
+    ring::interval_cache *ptr_intervals = intervals ? &interval_states : nullptr;
+
     std::ifstream ifs;
     uint64_t nQ = 0;
 
@@ -242,22 +516,38 @@ void query(const std::string &file, const std::string &queries)
         for (string &query_string : dummy_queries)
         {
             std::unordered_map<std::string, uint8_t> hash_table_vars;
-            std::vector<ring::triple_pattern> query;
-            vector<string> tokens_query = tokenizer(query_string, '.');
-            for (string &token : tokens_query)
+            std::vector<std::vector<ring::triple_pattern>> bgps;
+            solution_modifiers modifiers = parse_modifiers(query_string);
+            std::vector<std::vector<ring::filter_pattern>> filters;
+            query_groups groups = parse_groups(query_string);
+            for (string &part : groups.parts)
             {
-                auto triple_pattern = get_triple(token, hash_table_vars);
-                query.push_back(triple_pattern);
+                bgps.emplace_back();
+                filters.emplace_back();
+                vector<string> expressions = extract_filters(part);
+                vector<string> tokens_query = tokenizer(part, '.');
+                for (string &token : tokens_query)
+                {
+                    if (token.empty())
+                        continue;
+                    auto triple_pattern = get_triple(token, hash_table_vars);
+                    bgps.back().push_back(triple_pattern);
+                }
+                for (const string &expr : expressions)
+                {
+                    filters.back().push_back(get_filter(expr, hash_table_vars));
+                }
             }
 
             start = high_resolution_clock::now();
 
-            ring::ltj_algorithm<ring_type> ltj(&query, &graph);
-
             typedef std::vector<typename ring::ltj_algorithm<>::tuple_type> results_type;
             results_type res;
 
-            ltj.join(res, 1000, 600);
+            if (cost)
+                evaluate<ring::gao::gao_cost<ring_type>>(groups, bgps, filters, graph, adaptive, ptr_stats, ptr_plans, ptr_intervals, semijoin, modifiers, hash_table_vars, res);
+            else
+                evaluate<ring::gao::gao_size<ring_type>>(groups, bgps, filters, graph, adaptive, ptr_stats, ptr_plans, ptr_intervals, semijoin, modifiers, hash_table_vars, res);
 
             stop = high_resolution_clock::now();
             time_span = duration_cast<microseconds>(stop - start);
@@ -270,7 +560,7 @@ void query(const std::string &file, const std::string &queries)
 }
 
 template <class ring_type, class map_type>
-void mapped_query(const std::string &file, const std::string &so_mapping_file, const std::string &p_mapping_file, const std::string &queries)
+void mapped_query(const std::string &file, const std::string &so_mapping_file, const std::string &p_mapping_file, const std::string &queries, const bool adaptive, const bool cost, const bool cache, const bool intervals, const bool semijoin)
 {
     vector<string> dummy_queries;
 
@@ -295,11 +585,23 @@ void mapped_query(const std::string &file, const std::string &so_mapping_file, c
 
     cout << " Loading the index...";
     fflush(stdout);
-    sdsl::load_from_file(graph, file);
+    ring::load_index(graph, file);
 
     cout << endl
          << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
 
+    // Statistics for the planner, if they are up to date
+    ring::stats_catalog stats;
+    const ring::stats_catalog *ptr_stats = ring::load_stats(stats, graph, file) ? &stats : nullptr;
+
+    // Plans of the shapes already seen
+    ring::plan_cache<> plans;
+    ring::plan_cache<> *ptr_plans = cache ? &plans : nullptr;
+
+    // Intervals of the constants already resolved
+    ring::interval_cache interval_states;
+    ring::interval_cache *ptr_intervals = intervals ? &interval_states : nullptr;
+
     std::ifstream ifs;
     uint64_t nQ = 0;
 
@@ -312,15 +614,37 @@ void mapped_query(const std::string &file, const std::string &so_mapping_file, c
         for (string &query_string : dummy_queries)
         {
             std::unordered_map<std::string, uint8_t> hash_table_vars;
-            std::vector<ring::triple_pattern> query;
-            vector<string> tokens_query = parse_select(query_string);
+            std::vector<std::vector<ring::triple_pattern>> bgps;
+            solution_modifiers modifiers = parse_modifiers(query_string);
+            std::vector<std::vector<ring::filter_pattern>> filters;
+            query_groups groups = parse_groups(select_body(query_string));
 
             start = high_resolution_clock::now();
 
-            for (string &token : tokens_query)
+            // The filters are parsed once the triples of every part are known
+            vector<vector<string>> expressions;
+            for (string &part : groups.parts)
             {
-                auto triple_pattern = get_user_triple<map_type>(token, hash_table_vars, so_mapping, p_mapping);
-                query.push_back(triple_pattern);
+                bgps.emplace_back();
+                expressions.push_back(extract_filters(part));
+                vector<string> tokens_query = split_triples(part);
+                for (string &token : tokens_query)
+                {
+                    if (trim(token).empty())
+                        continue;
+                    auto triple_pattern = get_user_triple<map_type>(token, hash_table_vars, so_mapping, p_mapping);
+                    bgps.back().push_back(triple_pattern);
+                }
+            }
+            for (const auto &part_expressions : expressions)
+            {
+                filters.emplace_back();
+                for (const string &expr : part_expressions)
+                {
+                    ring::filter_pattern filter;
+                    if (get_user_filter<map_type>(expr, hash_table_vars, bgps, so_mapping, p_mapping, filter))
+                        filters.back().push_back(filter);
+                }
             }
 
             stop = high_resolution_clock::now();
@@ -329,12 +653,13 @@ void mapped_query(const std::string &file, const std::string &so_mapping_file, c
 
             start = high_resolution_clock::now();
 
-            ring::ltj_algorithm<ring_type> ltj(&query, &graph);
-
             typedef std::vector<typename ring::ltj_algorithm<>::tuple_type> results_type;
             results_type res;
 
-            ltj.join(res, 1000, 600);
+            if (cost)
+                evaluate<ring::gao::gao_cost<ring_type>>(groups, bgps, filters, graph, adaptive, ptr_stats, ptr_plans, ptr_intervals, semijoin, modifiers, hash_table_vars, res);
+            else
+                evaluate<ring::gao::gao_size<ring_type>>(groups, bgps, filters, graph, adaptive, ptr_stats, ptr_plans, ptr_intervals, semijoin, modifiers, hash_table_vars, res);
 
             stop = high_resolution_clock::now();
             time_span = duration_cast<microseconds>(stop - start);
@@ -367,9 +692,32 @@ void mapped_query(const std::string &file, const std::string &so_mapping_file, c
 
 int main(int argc, char *argv[])
 {
+    // Optional last arguments: choose the variable order during the join (adaptive),
+    // compute the initial order with the cost-based planner (cost)
+    // reuse the plans of the queries with the same shape (cache)
+    // reuse the intervals of the constants of previous queries (intervals)
+    // and/or prune the candidates of the variables of acyclic queries with semi-joins (semijoin)
+    bool adaptive = false, cost = false, cache = false, intervals = false, semijoin = false;
+    while (argc > 3)
+    {
+        std::string option = argv[argc - 1];
+        if (option == "adaptive")
+            adaptive = true;
+        else if (option == "cost")
+            cost = true;
+        else if (option == "cache")
+            cache = true;
+        else if (option == "intervals")
+            intervals = true;
+        else if (option == "semijoin")
+            semijoin = true;
+        else
+            break;
+        --argc;
+    }
     if (argc != 3 && argc != 5)
     {
-        std::cout << "Usage: " << argv[0] << " <index> <queries>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <index> <queries> [<so mapping> <p mapping>] [adaptive] [cost] [cache] [intervals] [semijoin]" << std::endl;
         return 0;
     }
 
@@ -381,23 +729,51 @@ int main(int argc, char *argv[])
     {
         if (type == "ring")
         {
-            query<ring::ring<>>(index, queries);
+            query<ring::ring<>>(index, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "c-ring")
         {
-            query<ring::c_ring>(index, queries);
+            query<ring::c_ring>(index, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-sel")
         {
-            query<ring::ring_sel>(index, queries);
+            query<ring::ring_sel>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-simd")
+        {
+            query<ring::ring_simd>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-cl")
+        {
+            query<ring::ring_cl>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-alpha")
+        {
+            query<ring::ring_alpha>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-ap")
+        {
+            query<ring::ring_ap>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-delta")
+        {
+            query<ring::ring_delta<>>(index, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-dyn-basic")
         {
-            query<ring::ring_dyn>(index, queries);
+            query<ring::ring_dyn>(index, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-dyn")
         {
-            query<ring::medium_ring_dyn>(index, queries);
+            query<ring::medium_ring_dyn>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-dyn-read")
+        {
+            query<ring::read_ring_dyn>(index, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            query<ring::update_ring_dyn>(index, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else
         {
@@ -411,23 +787,51 @@ int main(int argc, char *argv[])
         std::string p_mapping = argv[4];
         if (type == "ring")
         {
-            mapped_query<ring::ring<>, ring::basic_map>(index, so_mapping, p_mapping, queries);
+            mapped_query<ring::ring<>, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "c-ring")
         {
-            mapped_query<ring::c_ring, ring::basic_map>(index, so_mapping, p_mapping, queries);
+            mapped_query<ring::c_ring, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-sel")
         {
-            mapped_query<ring::ring_sel, ring::basic_map>(index, so_mapping, p_mapping, queries);
+            mapped_query<ring::ring_sel, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-simd")
+        {
+            mapped_query<ring::ring_simd, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-cl")
+        {
+            mapped_query<ring::ring_cl, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-alpha")
+        {
+            mapped_query<ring::ring_alpha, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-ap")
+        {
+            mapped_query<ring::ring_ap, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-delta")
+        {
+            mapped_query<ring::ring_delta<>, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-dyn-basic")
         {
-            mapped_query<ring::ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+            mapped_query<ring::ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else if (type == "ring-dyn")
         {
-            mapped_query<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries);
+            mapped_query<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-dyn-read")
+        {
+            mapped_query<ring::read_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
+        }
+        else if (type == "ring-dyn-update")
+        {
+            mapped_query<ring::update_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, adaptive, cost, cache, intervals, semijoin);
         }
         else
         {
@@ -0,0 +1,140 @@
+/*
+ * remap-ids.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include "ring.hpp"
+#include "dict_map.hpp"
+#include <fstream>
+#include <chrono>
+
+using namespace std;
+
+using namespace std::chrono;
+using timer = std::chrono::high_resolution_clock;
+
+std::string get_type(const std::string &file)
+{
+    auto p = file.find_last_of('.');
+    return file.substr(p + 1);
+}
+
+std::string get_file_without_type(const std::string &file)
+{
+    auto p = file.find_last_of('.');
+    return file.substr(0, p);
+}
+
+template <class map_type>
+void remap_mapping(const std::string &mapping_file, const vector<uint64_t> &map)
+{
+    map_type mapping;
+    std::ifstream infs(mapping_file, std::ios::binary | std::ios::in);
+    mapping.load(infs);
+    cout << " Mapping loaded " << mapping.bit_size() / 8 << " bytes" << endl;
+
+    mapping.remap(map);
+
+    std::string outfile = get_file_without_type(mapping_file) + ".remapped.mapping";
+    std::ofstream out(outfile, std::ios::binary | std::ios::trunc | std::ios::out);
+    mapping.serialize(out);
+    cout << " Remapped mapping stored " << mapping.bit_size() / 8 << " bytes" << endl;
+}
+
+template <class ring_type, class map_type>
+void remap_index(const std::string &file, const std::string &so_mapping_file, const std::string &p_mapping_file)
+{
+    ring_type graph;
+
+    cout << " Loading the index...";
+    fflush(stdout);
+    sdsl::load_from_file(graph, file);
+
+    cout << endl
+         << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
+
+    uint64_t old_so = graph.max_so(), old_p = graph.max_p();
+    vector<uint64_t> so_map, p_map;
+    auto start = timer::now();
+    graph.remap_ids(so_map, p_map);
+    auto stop = timer::now();
+
+    cout << " SO alphabet: " << old_so << " -> " << graph.max_so() << endl;
+    cout << " P alphabet: " << old_p << " -> " << graph.max_p() << endl;
+    cout << " Index remapped " << sdsl::size_in_bytes(graph) << " bytes in "
+         << duration_cast<milliseconds>(stop - start).count() << " ms" << endl;
+
+    std::string outfile = get_file_without_type(file) + ".remapped." + get_type(file);
+    sdsl::store_to_file(graph, outfile);
+    std::cout << "Remapped Ring stored" << std::endl;
+
+    if (!so_mapping_file.empty())
+    {
+        remap_mapping<map_type>(so_mapping_file, so_map);
+        remap_mapping<map_type>(p_mapping_file, p_map);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <index> [<so mapping> <p mapping>]" << std::endl;
+        return 0;
+    }
+
+    std::string index = argv[1];
+    std::string so_mapping = argc == 4 ? argv[2] : "";
+    std::string p_mapping = argc == 4 ? argv[3] : "";
+    std::string type = get_type(index);
+
+    if (type == "ring")
+    {
+        remap_index<ring::ring<>, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "c-ring")
+    {
+        remap_index<ring::c_ring, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "ring-sel")
+    {
+        remap_index<ring::ring_sel, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "ring-dyn-basic")
+    {
+        remap_index<ring::ring_dyn, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "ring-dyn")
+    {
+        remap_index<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "ring-dyn-read")
+    {
+        remap_index<ring::read_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else if (type == "ring-dyn-update")
+    {
+        remap_index<ring::update_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping);
+    }
+    else
+    {
+        std::cout << "Type of index: " << type << " is not supported." << std::endl;
+    }
+
+    return 0;
+}
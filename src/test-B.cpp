@@ -253,19 +253,25 @@ void instantiate_and_run()
   D.shrink_to_fit();
   queries.shrink_to_fit();
 
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 256, 1024>>> big_wm_str_1;
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 512, 1024>>> big_wm_str_2;
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 1024, 1024>>> big_wm_str_3;
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 2048, 1024>>> big_wm_str_4;
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 4096, 1024>>> big_wm_str_5;
-  typedef dyn::wm_string<dyn::succinct_bitvector<dyn::spsi<dyn::packed_bit_vector, 8192, 1024>>> big_wm_str_6;
-
+  typedef dyn_wm_str<256, 1024> big_wm_str_1;
+  typedef dyn_wm_str<512, 1024> big_wm_str_2;
+  typedef dyn_wm_str<1024, 1024> big_wm_str_3;
+  typedef dyn_wm_str<2048, 1024> big_wm_str_4;
+  typedef dyn_wm_str<4096, 1024> big_wm_str_5;
+  typedef dyn_wm_str<8192, 1024> big_wm_str_6;
+
+  cout << "B, B_leaf, build time, size, query, insert, remove edge, remove node" << endl;
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_1>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_1>>>(D, queries, insert_triples, nodes, 1024, 256);
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_2>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_2>>>(D, queries, insert_triples, nodes, 1024, 512);
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_3>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_3>>>(D, queries, insert_triples, nodes, 1024, 1024);
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_4>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_4>>>(D, queries, insert_triples, nodes, 1024, 2048);
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_5>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_5>>>(D, queries, insert_triples, nodes, 1024, 4096);
   test_ring_all<ring::ring<ring::bwt_dyn<dyn::suc_bv, big_wm_str_6>, ring::bwt_dyn<dyn::suc_bv, big_wm_str_6>>>(D, queries, insert_triples, nodes, 1024, 8192);
+
+  // Presets used by build-index/query-index
+  test_ring_all<ring::update_ring_dyn>(D, queries, insert_triples, nodes, 16, 512);
+  test_ring_all<ring::medium_ring_dyn>(D, queries, insert_triples, nodes, 32, 2048);
+  test_ring_all<ring::read_ring_dyn>(D, queries, insert_triples, nodes, 32, 8192);
 }
 
 int main()
@@ -20,11 +20,14 @@
 #include <iostream>
 #include <utility>
 #include "ring.hpp"
+#include "ring_versioned.hpp"
 #include "dict_map.hpp"
 #include <chrono>
 #include <triple_pattern.hpp>
 #include <ltj_algorithm.hpp>
 #include "utils.hpp"
+#include <thread>
+#include <atomic>
 
 using namespace std;
 
@@ -73,7 +76,7 @@ std::string trim(const std::string &s)
     return rtrim(ltrim(s));
 }
 
-std::vector<std::string> regex_tokenizer(const std::string &input, std::regex regex_token)
+std::vector<std::string> regex_tokenizer(const std::string &input, const std::regex &regex_token)
 {
     std::smatch match;
     std::vector<std::string> res;
@@ -105,10 +108,15 @@ std::vector<std::string> parse_select(const std::string &input)
     return res;
 }
 
+// Parses all the triples first and resolves their terms with one batch per dictionary.
+// locate_batch gives 0 to the terms that are not in the dictionaries: the triples
+// with such a term are not in the index, so they are skipped (and counted in cerr)
+// instead of being deleted or inserted with the ID 0
 template <class map_type>
 void parse_triples(std::vector<std::string> &lines, std::vector<spo_triple> &res, map_type &so_mapping, map_type &p_mapping)
 {
-    std::regex token_regex("(?:\".*\"|[^[:space:]])+");
+    static const std::regex token_regex("(?:\".*\"|[^[:space:]])+");
+    vector<string> so_terms, p_terms;
     for (std::string &line : lines)
     {
         size_t index = 0, tmp_index = 0;
@@ -117,10 +125,28 @@ void parse_triples(std::vector<std::string> &lines, std::vector<spo_triple> &res
             tmp_index = line.find(" . ", index);
 
             vector<string> terms = regex_tokenizer(line.substr(index, tmp_index - index), token_regex);
-            res.emplace_back(spo_triple(so_mapping.locate(terms[0]), p_mapping.locate(terms[1]), so_mapping.locate(terms[2])));
+            so_terms.emplace_back(terms[0]);
+            p_terms.emplace_back(terms[1]);
+            so_terms.emplace_back(terms[2]);
             index = tmp_index + 2;
         }
     }
+    vector<uint64_t> so_ids = so_mapping.locate_batch(so_terms);
+    vector<uint64_t> p_ids = p_mapping.locate_batch(p_terms);
+    uint64_t skipped = 0;
+    for (uint64_t i = 0; i < p_ids.size(); i++)
+    {
+        if (so_ids[2 * i] == 0 || p_ids[i] == 0 || so_ids[2 * i + 1] == 0)
+        {
+            skipped++;
+            continue;
+        }
+        res.emplace_back(spo_triple(so_ids[2 * i], p_ids[i], so_ids[2 * i + 1]));
+    }
+    if (skipped > 0)
+    {
+        cerr << skipped << " triples skipped: some of their terms are not in the dictionaries" << endl;
+    }
 }
 
 bool is_variable(string &s)
@@ -152,7 +178,7 @@ uint64_t get_constant(string &s)
 template <class map_type>
 ring::triple_pattern get_user_triple(string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars, map_type &so_mapping, map_type &p_mapping)
 {
-    std::regex token_regex("(?:\".*\"|[^[:space:]])+");
+    static const std::regex token_regex("(?:\".*\"|[^[:space:]])+");
     vector<string> terms = regex_tokenizer(s, token_regex);
 
     ring::triple_pattern triple;
@@ -316,6 +342,121 @@ void mapped_delete_insert(const std::string &file, const std::string &so_mapping
     }
 }
 
+// The same workload as mapped_delete_insert, but the updates run in a writer thread
+// while the query is answered on the last published version
+template <class ring_type, class map_type>
+void mapped_concurrent_delete_insert(const std::string &file, const std::string &so_mapping_file, const std::string &p_mapping_file, const std::string &queries, const std::string &triples_file)
+{
+    vector<string> dummy_queries, dummy_triples;
+
+    bool result = get_file_content(queries, dummy_queries);
+    bool result2 = get_file_content(triples_file, dummy_triples);
+
+    // Load SO Dictionary Mapping
+    map_type so_mapping;
+    std::ifstream so_infs(so_mapping_file, std::ios::binary | std::ios::in);
+    so_mapping.load(so_infs);
+
+    cout << endl
+         << " SO Mapping loaded " << so_mapping.bit_size() / 8 << " bytes" << endl;
+
+    // Load P Dictionary Mapping
+    map_type p_mapping;
+    std::ifstream p_infs(p_mapping_file, std::ios::binary | std::ios::in);
+    p_mapping.load(p_infs);
+
+    cout << endl
+         << " P Mapping loaded " << p_mapping.bit_size() / 8 << " bytes" << endl;
+
+    ring::ring_versioned<ring_type> graph;
+
+    cout << " Loading the index...";
+    fflush(stdout);
+    sdsl::load_from_file(graph, file);
+
+    cout << endl
+         << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
+
+    if (result && result2)
+    {
+        typedef ring::ring_delta<ring_type> version_type;
+        std::unordered_map<std::string, uint8_t> hash_table_vars;
+        std::vector<ring::triple_pattern> query;
+        typedef std::vector<typename ring::ltj_algorithm<version_type>::tuple_type> results_type;
+
+        // Dictionaries are only read here, before the writer starts
+        vector<string> tokens_query = parse_select(dummy_queries[0]);
+        for (string &token : tokens_query)
+        {
+            auto triple_pattern = get_user_triple<map_type>(token, hash_table_vars, so_mapping, p_mapping);
+            query.push_back(triple_pattern);
+        }
+
+        vector<spo_triple> triples;
+        parse_triples<map_type>(dummy_triples, triples, so_mapping, p_mapping); // triples parse
+
+        uint64_t batch_size = 100;
+        std::vector<double> update_times;
+        std::atomic<bool> done(false);
+
+        std::thread writer([&]() {
+            high_resolution_clock::time_point start, stop;
+            duration<double> time_span;
+            // DELETE the triples
+            start = high_resolution_clock::now();
+            for (spo_triple &t : triples)
+            {
+                graph.remove_edge(t);
+            }
+            graph.publish();
+            stop = high_resolution_clock::now();
+            time_span = duration_cast<microseconds>(stop - start);
+            update_times.push_back(time_span.count());
+
+            // INSERT them again in batches
+            for (auto it = triples.begin(); it != triples.end();)
+            {
+                auto batch_end = it + std::min<uint64_t>(batch_size, triples.end() - it);
+                start = high_resolution_clock::now();
+                for (; it != batch_end; ++it)
+                {
+                    graph.insert(*it);
+                }
+                graph.publish();
+                stop = high_resolution_clock::now();
+                time_span = duration_cast<microseconds>(stop - start);
+                update_times.push_back(time_span.count());
+            }
+            done = true;
+        });
+
+        uint64_t nQ = 0;
+        high_resolution_clock::time_point start, stop;
+        duration<double> time_span;
+        do
+        {
+            start = high_resolution_clock::now();
+
+            auto version = graph.pin();
+            ring::ltj_algorithm<version_type> ltj(&query, version.get());
+            results_type res;
+            ltj.join(res, 1000, 600);
+
+            stop = high_resolution_clock::now();
+            time_span = duration_cast<microseconds>(stop - start);
+            double query_time = time_span.count();
+            cout << nQ << ";" << graph.version() << ";" << res.size() << ";" << (unsigned long long)(query_time * 1000000000ULL) << endl;
+            nQ++;
+        } while (!done);
+        writer.join();
+
+        for (uint64_t i = 0; i < update_times.size(); ++i)
+        {
+            cout << "update " << i << ";" << (unsigned long long)(update_times[i] * 1000000000ULL) << endl;
+        }
+    }
+}
+
 int main(int argc, char *argv[])
 {
     if (argc != 6)
@@ -339,6 +480,18 @@ int main(int argc, char *argv[])
     {
         mapped_delete_insert<ring::medium_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, triples);
     }
+    else if (type == "ring-dyn-read")
+    {
+        mapped_delete_insert<ring::read_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, triples);
+    }
+    else if (type == "ring-dyn-update")
+    {
+        mapped_delete_insert<ring::update_ring_dyn, ring::basic_map>(index, so_mapping, p_mapping, queries, triples);
+    }
+    else if (type == "ring-delta")
+    {
+        mapped_concurrent_delete_insert<ring::ring<>, ring::basic_map>(index, so_mapping, p_mapping, queries, triples);
+    }
     else
     {
         std::cout << "Type of index: " << type << " is not supported." << std::endl;
@@ -33,6 +33,11 @@ echo Processing insert
 ./insert-edge ../$1/wikidata-wcg-filtered.nt.updated.ring-dyn ../$2/updates/insert.txt ../$1/wikidata-wcg-filtered.nt.so.updated.mapping ../$1/wikidata-wcg-filtered.nt.p.updated.mapping > ../$3/updates/output/insert/ring-dyn-map
 echo "[Done]"
 
+echo Processing insert with update log
+rm -f ../$1/wikidata-wcg-filtered.nt.updated.ring-dyn.log
+./insert-edge ../$1/wikidata-wcg-filtered.nt.updated.ring-dyn ../$2/updates/insert.txt ../$1/wikidata-wcg-filtered.nt.so.updated.mapping ../$1/wikidata-wcg-filtered.nt.p.updated.mapping ../$1/wikidata-wcg-filtered.nt.updated.ring-dyn.log > ../$3/updates/output/insert/ring-dyn-map-log
+echo "[Done]"
+
 echo Processing deleteNode
 ./delete-node ../$1/wikidata-wcg-filtered.nt.ring-dyn ../$2/updates/deleteNode.txt ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping > ../$3/updates/output/deleteNode/ring-dyn-map
 echo "[Done]"
@@ -41,4 +46,8 @@ echo "Processing insert then query"
 ./update-query ../$1/wikidata-wcg-filtered.nt.ring-dyn ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping ../$2/insertJoin.txt ../$2/insertJoinTriples.txt > ../$3/updates/output/insertJoin/ring-dyn-map
 echo "[Done]"
 
+echo "Processing concurrent insert and query"
+./update-query ../$1/wikidata-wcg-filtered-num.nt.ring-delta ../$1/wikidata-wcg-filtered.nt.so.mapping ../$1/wikidata-wcg-filtered.nt.p.mapping ../$2/insertJoin.txt ../$2/insertJoinTriples.txt > ../$3/updates/output/insertJoin/ring-delta
+echo "[Done]"
+
 cd ..
\ No newline at end of file